@@ -0,0 +1,226 @@
+//
+// atlas: sprite sheets packed into one image
+//
+// Small images are packed into shelves (rows as tall as their tallest
+// sprite) of a single large VGImage; each sprite is a child image that
+// shares the atlas storage, so hundreds of icons need one image object.
+//
+#include <stdlib.h>
+#include <string.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+#include "vgcheck.h"
+
+#define ATLAS_PAD 1					   // gap between sprites, so filtering does not bleed
+
+typedef struct {
+	int y;						   // bottom of the shelf
+	int height;
+	int x;						   // start of the free space
+} Shelf;
+
+typedef struct {
+	VGImage image;					   // child of the atlas image
+	int width;
+	int height;
+} Sprite;
+
+struct Atlas {
+	VGImage image;
+	int width;
+	int height;
+	int alpha;					   // alpha mode of added rasters
+	VGImageFormat format;
+	Shelf *shelves;
+	int nshelves;
+	int top;					   // bottom of the unused space above the shelves
+	Sprite *sprites;
+	int count;
+	int cap;
+};
+
+// AtlasCreate allocates a w x h atlas; alphamode is as for createImage
+Atlas *AtlasCreate(int w, int h, int alphamode) {
+	Atlas *a = (Atlas *) calloc(1, sizeof(Atlas));
+	if (a == NULL) {
+		return NULL;
+	}
+	a->format = alphaformat(alphamode);
+	a->image = vgCreateImage(a->format, w, h, VG_IMAGE_QUALITY_BETTER);
+	if (a->image == VG_INVALID_HANDLE) {
+		free(a);
+		return NULL;
+	}
+	vgClearImage(a->image, 0, 0, w, h);
+	a->width = w;
+	a->height = h;
+	a->alpha = alphamode;
+	return a;
+}
+
+// place finds room for a w x h sprite, returning its position in (x,y) and the shortest
+// shelf it fits on, nshelves to start a new one, or -1 if there is no room.
+// Nothing is taken until reserve.
+static int place(Atlas * a, int w, int h, int *x, int *y) {
+	Shelf *s;
+	int i, best = -1;
+
+	for (i = 0; i < a->nshelves; i++) {
+		s = &a->shelves[i];
+		if (s->height >= h && s->x + w <= a->width && (best < 0 || s->height < a->shelves[best].height)) {
+			best = i;
+		}
+	}
+	if (best >= 0) {
+		*x = a->shelves[best].x;
+		*y = a->shelves[best].y;
+		return best;
+	}
+	if (a->top + h > a->height || w > a->width) {
+		return -1;
+	}
+	s = (Shelf *) realloc(a->shelves, (a->nshelves + 1) * sizeof(Shelf));
+	if (s == NULL) {
+		return -1;
+	}
+	a->shelves = s;
+	*x = 0;
+	*y = a->top;
+	return a->nshelves;
+}
+
+// reserve takes the room place found on shelf i for a w x h sprite
+static void reserve(Atlas * a, int i, int w, int h) {
+	Shelf *s;
+
+	if (i == a->nshelves) {
+		s = &a->shelves[a->nshelves++];
+		s->y = a->top;
+		s->height = h;
+		s->x = 0;
+		a->top += h + ATLAS_PAD;
+	}
+	a->shelves[i].x += w + ATLAS_PAD;
+}
+
+// AtlasAdd copies a w x h raster of red, green, blue, alpha values (bottom row first,
+// stride bytes per row) into the atlas, returning its sprite number, or -1 if it is full.
+int AtlasAdd(Atlas * a, const VGubyte * data, int w, int h, int stride) {
+	Sprite *sp;
+	VGubyte *pre = NULL;
+	VGImage image;
+	int x, y, i, shelf;
+
+	if (w <= 0 || h <= 0) {
+		return -1;
+	}
+	if (a->count == a->cap) {
+		sp = (Sprite *) realloc(a->sprites, (a->cap * 2 + 16) * sizeof(Sprite));
+		if (sp == NULL) {
+			return -1;
+		}
+		a->sprites = sp;
+		a->cap = a->cap * 2 + 16;
+	}
+	shelf = place(a, w, h, &x, &y);
+	if (shelf < 0) {
+		return -1;
+	}
+	image = vgChildImage(a->image, x, y, w, h);
+	if (image == VG_INVALID_HANDLE) {
+		vgcheck("AtlasAdd");
+		return -1;
+	}
+	if (a->alpha == ALPHA_PREMULTIPLY) {
+		pre = (VGubyte *) malloc(w * h * 4);
+		if (pre == NULL) {
+			vgDestroyImage(image);
+			return -1;
+		}
+		for (i = 0; i < h; i++) {
+			PremultiplyRGBA(pre + i * w * 4, data + i * stride, w);
+		}
+		data = pre;
+		stride = w * 4;
+	}
+	vgImageSubData(a->image, data, stride, a->format, x, y, w, h);
+	free(pre);
+	reserve(a, shelf, w, h);
+
+	sp = &a->sprites[a->count];
+	sp->image = image;
+	sp->width = w;
+	sp->height = h;
+	vgcheck("AtlasAdd");
+	return a->count++;
+}
+
+// AtlasAddJpeg decodes a JPEG file into the atlas, returning its sprite number, or -1
+int AtlasAddJpeg(Atlas * a, const char *filename) {
+	VGubyte *data;
+	int w, h, n, alpha;
+
+	data = decodeJpeg(filename, &w, &h);
+	if (data == NULL) {
+		return -1;
+	}
+	alpha = a->alpha;
+	a->alpha = ALPHA_PREMULTIPLIED;			   // JPEGs are opaque
+	n = AtlasAdd(a, data, w, h, w * 4);
+	a->alpha = alpha;
+	free(data);
+	return n;
+}
+
+// AtlasSprite returns the child image of a sprite, and its dimensions
+VGImage AtlasSprite(Atlas * a, int sprite, int *w, int *h) {
+	if (sprite < 0 || sprite >= a->count) {
+		return VG_INVALID_HANDLE;
+	}
+	*w = a->sprites[sprite].width;
+	*h = a->sprites[sprite].height;
+	return a->sprites[sprite].image;
+}
+
+// AtlasDrawList draws n sprites, sprite[i] at (x[i],y[i]), blended and
+// transformed like shapes.
+void AtlasDrawList(Atlas * a, const int *sprite, const VGfloat * x, const VGfloat * y, int n) {
+	VGfloat mm[9];
+	int i;
+
+	vgGetMatrix(mm);
+	vgSeti(VG_MATRIX_MODE, VG_MATRIX_IMAGE_USER_TO_SURFACE);
+	for (i = 0; i < n; i++) {
+		if (sprite[i] < 0 || sprite[i] >= a->count) {
+			continue;
+		}
+		vgLoadMatrix(mm);
+		vgTranslate(x[i], y[i]);
+		vgDrawImage(a->sprites[sprite[i]].image);
+	}
+	vgSeti(VG_MATRIX_MODE, VG_MATRIX_PATH_USER_TO_SURFACE);
+	vgcheck("AtlasDrawList");
+}
+
+// AtlasDraw draws a sprite at (x,y)
+void AtlasDraw(Atlas * a, int sprite, VGfloat x, VGfloat y) {
+	AtlasDrawList(a, &sprite, &x, &y, 1);
+}
+
+// AtlasDestroy frees the sprites and the atlas image
+void AtlasDestroy(Atlas * a) {
+	int i;
+
+	if (a == NULL) {
+		return;
+	}
+	for (i = 0; i < a->count; i++) {
+		vgDestroyImage(a->sprites[i].image);
+	}
+	vgDestroyImage(a->image);
+	free(a->sprites);
+	free(a->shelves);
+	free(a);
+}
@@ -0,0 +1,256 @@
+package openvg
+
+/*
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h" // font information
+#include "shapes.h"   // C API
+*/
+import "C"
+import (
+	"math"
+	"unsafe"
+)
+
+// Batch records drawing commands in Go memory, to be drawn by Flush with
+// a single call into C, instead of a cgo call per primitive.
+// The methods follow the package functions of the same name.
+type Batch struct {
+	buf []uint32
+}
+
+// NewBatch makes a command batch, with room for n words of commands
+func NewBatch(n int) *Batch {
+	return &Batch{buf: make([]uint32, 0, n)}
+}
+
+// fw returns the bits of a float argument
+func fw(v VGfloat) uint32 {
+	return math.Float32bits(float32(v))
+}
+
+// Flush draws the recorded commands, and empties the batch
+func (b *Batch) Flush() {
+	if len(b.buf) > 0 {
+		C.DrawCommands((*C.VGint)(unsafe.Pointer(&b.buf[0])), C.int(len(b.buf)))
+		b.buf = b.buf[:0]
+	}
+}
+
+// Reset discards the recorded commands
+func (b *Batch) Reset() {
+	b.buf = b.buf[:0]
+}
+
+// Len returns the number of words recorded
+func (b *Batch) Len() int {
+	return len(b.buf)
+}
+
+// Rect records a rectangle at (x,y) with dimensions (w,h)
+func (b *Batch) Rect(x, y, w, h VGfloat) {
+	b.buf = append(b.buf, C.CMD_RECT, fw(x), fw(y), fw(w), fw(h))
+}
+
+// Roundrect records a rounded rectangle at (x,y) with dimensions (w,h), corners rw, rh
+func (b *Batch) Roundrect(x, y, w, h, rw, rh VGfloat) {
+	b.buf = append(b.buf, C.CMD_ROUNDRECT, fw(x), fw(y), fw(w), fw(h), fw(rw), fw(rh))
+}
+
+// Ellipse records an ellipse at (x,y) with dimensions (w,h)
+func (b *Batch) Ellipse(x, y, w, h VGfloat) {
+	b.buf = append(b.buf, C.CMD_ELLIPSE, fw(x), fw(y), fw(w), fw(h))
+}
+
+// Circle records a circle centered at (x,y) with diameter d
+func (b *Batch) Circle(x, y, d VGfloat) {
+	b.buf = append(b.buf, C.CMD_CIRCLE, fw(x), fw(y), fw(d))
+}
+
+// Line records a line from (x1,y1) to (x2,y2)
+func (b *Batch) Line(x1, y1, x2, y2 VGfloat) {
+	b.buf = append(b.buf, C.CMD_LINE, fw(x1), fw(y1), fw(x2), fw(y2))
+}
+
+// Arc records an arc at (x,y) with dimensions (w,h), from angle sa extended by aext
+func (b *Batch) Arc(x, y, w, h, sa, aext VGfloat) {
+	b.buf = append(b.buf, C.CMD_ARC, fw(x), fw(y), fw(w), fw(h), fw(sa), fw(aext))
+}
+
+// Qbezier records a quadratic bezier curve
+func (b *Batch) Qbezier(sx, sy, cx, cy, ex, ey VGfloat) {
+	b.buf = append(b.buf, C.CMD_QBEZIER, fw(sx), fw(sy), fw(cx), fw(cy), fw(ex), fw(ey))
+}
+
+// Cbezier records a cubic bezier curve
+func (b *Batch) Cbezier(sx, sy, cx, cy, px, py, ex, ey VGfloat) {
+	b.buf = append(b.buf, C.CMD_CBEZIER, fw(sx), fw(sy), fw(cx), fw(cy), fw(px), fw(py), fw(ex), fw(ey))
+}
+
+// poly records a polygon or polyline
+func (b *Batch) poly(op uint32, x, y []VGfloat) {
+	n := len(x)
+	if len(y) < n {
+		n = len(y)
+	}
+	b.buf = append(b.buf, op, uint32(n))
+	for _, v := range x[:n] {
+		b.buf = append(b.buf, fw(v))
+	}
+	for _, v := range y[:n] {
+		b.buf = append(b.buf, fw(v))
+	}
+}
+
+// Polygon records a filled polygon with vertices in x and y
+func (b *Batch) Polygon(x, y []VGfloat) {
+	b.poly(C.CMD_POLYGON, x, y)
+}
+
+// Polyline records a polyline with vertices in x and y
+func (b *Batch) Polyline(x, y []VGfloat) {
+	b.poly(C.CMD_POLYLINE, x, y)
+}
+
+// FillRGB records the fill color
+func (b *Batch) FillRGB(r, g, bl uint8, alpha VGfloat) {
+	b.buf = append(b.buf, C.CMD_FILL, fw(VGfloat(r)), fw(VGfloat(g)), fw(VGfloat(bl)), fw(alpha))
+}
+
+// StrokeRGB records the stroke color
+func (b *Batch) StrokeRGB(r, g, bl uint8, alpha VGfloat) {
+	b.buf = append(b.buf, C.CMD_STROKE, fw(VGfloat(r)), fw(VGfloat(g)), fw(VGfloat(bl)), fw(alpha))
+}
+
+// FillColor records the fill color by name or rgb(r,g,b) string
+func (b *Batch) FillColor(s string, alpha ...VGfloat) {
+	c := Colorlookup(s)
+	if len(alpha) == 0 {
+		b.FillRGB(c.Red, c.Green, c.Blue, 1)
+	} else {
+		b.FillRGB(c.Red, c.Green, c.Blue, alpha[0])
+	}
+}
+
+// StrokeColor records the stroke color by name or rgb(r,g,b) string
+func (b *Batch) StrokeColor(s string, alpha ...VGfloat) {
+	c := Colorlookup(s)
+	if len(alpha) == 0 {
+		b.StrokeRGB(c.Red, c.Green, c.Blue, 1)
+	} else {
+		b.StrokeRGB(c.Red, c.Green, c.Blue, alpha[0])
+	}
+}
+
+// FillColorHandle records the fill color of a resolved color
+func (b *Batch) FillColorHandle(c *ColorHandle) {
+	b.FillRGB(c.Red, c.Green, c.Blue, c.Alpha)
+}
+
+// StrokeColorHandle records the stroke color of a resolved color
+func (b *Batch) StrokeColorHandle(c *ColorHandle) {
+	b.StrokeRGB(c.Red, c.Green, c.Blue, c.Alpha)
+}
+
+// StrokeWidth records the stroke width
+func (b *Batch) StrokeWidth(w VGfloat) {
+	b.buf = append(b.buf, C.CMD_STROKEWIDTH, fw(w))
+}
+
+// BackgroundRGB records clearing the screen to a color
+func (b *Batch) BackgroundRGB(r, g, bl uint8, alpha VGfloat) {
+	b.buf = append(b.buf, C.CMD_BACKGROUND, fw(VGfloat(r)), fw(VGfloat(g)), fw(VGfloat(bl)), fw(alpha))
+}
+
+// Translate records moving the coordinate system to (x,y)
+func (b *Batch) Translate(x, y VGfloat) {
+	b.buf = append(b.buf, C.CMD_TRANSLATE, fw(x), fw(y))
+}
+
+// Rotate records rotating the coordinate system by r degrees
+func (b *Batch) Rotate(r VGfloat) {
+	b.buf = append(b.buf, C.CMD_ROTATE, fw(r))
+}
+
+// Scale records scaling the coordinate system by (x,y)
+func (b *Batch) Scale(x, y VGfloat) {
+	b.buf = append(b.buf, C.CMD_SCALE, fw(x), fw(y))
+}
+
+// Shear records shearing the coordinate system by (x,y)
+func (b *Batch) Shear(x, y VGfloat) {
+	b.buf = append(b.buf, C.CMD_SHEAR, fw(x), fw(y))
+}
+
+// ClipRect records limiting drawing to a rectangle
+func (b *Batch) ClipRect(x, y, w, h int) {
+	b.buf = append(b.buf, C.CMD_CLIPRECT, fw(VGfloat(x)), fw(VGfloat(y)), fw(VGfloat(w)), fw(VGfloat(h)))
+}
+
+// ClipEnd records the end of clipping
+func (b *Batch) ClipEnd() {
+	b.buf = append(b.buf, C.CMD_CLIPEND)
+}
+
+// text records text with an alignment; the string is copied into the batch with a NUL
+func (b *Batch) text(align uint32, x, y VGfloat, s string, font string, size int) {
+	words := (len(s) + 4) / 4
+	b.buf = append(b.buf, C.CMD_TEXT, fontnumber(font), uint32(size), align, fw(x), fw(y), uint32(words))
+	start := len(b.buf)
+	for i := 0; i < words; i++ {
+		b.buf = append(b.buf, 0)
+	}
+	copy((*[1 << 30]byte)(unsafe.Pointer(&b.buf[start]))[:words*4], s)
+}
+
+// Text records text at (x,y)
+func (b *Batch) Text(x, y VGfloat, s string, font string, size int) {
+	b.text(C.CMD_ALIGN_START, x, y, s, font, size)
+}
+
+// TextMid records text centered at (x,y)
+func (b *Batch) TextMid(x, y VGfloat, s string, font string, size int) {
+	b.text(C.CMD_ALIGN_MID, x, y, s, font, size)
+}
+
+// TextEnd records text ending at (x,y)
+func (b *Batch) TextEnd(x, y VGfloat, s string, font string, size int) {
+	b.text(C.CMD_ALIGN_END, x, y, s, font, size)
+}
+
+// fontnumber returns the command buffer number of a font name, as selectfont
+func fontnumber(s string) uint32 {
+	switch s {
+	case "sans":
+		return C.CMD_FONT_SANS
+	case "mono":
+		return C.CMD_FONT_MONO
+	}
+	return C.CMD_FONT_SERIF
+}
+
+// Retained finds what changes from one frame's batch to the next
+type Retained struct {
+	r *C.Retained
+}
+
+// NewRetained makes a retained mode drawing
+func NewRetained() *Retained {
+	return &Retained{C.RetainedOpen()}
+}
+
+// Damage invalidates the window area of the commands in b that differ from the last
+// batch's, for StartDamaged; all of the window the first time
+func (r *Retained) Damage(b *Batch) {
+	if len(b.buf) == 0 {
+		C.RetainedDamage(r.r, nil, 0)
+		return
+	}
+	C.RetainedDamage(r.r, (*C.VGint)(unsafe.Pointer(&b.buf[0])), C.int(len(b.buf)))
+}
+
+// Close frees the retained drawing
+func (r *Retained) Close() {
+	C.RetainedClose(r.r)
+	r.r = nil
+}
@@ -0,0 +1,64 @@
+// deltaexport: reconstruct the frames of a delta compressed recording (RecordOpen with RECORD_DELTA)
+// usage: deltaexport [-p prefix] [-r] file
+//	-p prefix	write each frame as prefix-00000.png, prefix-00001.png, ...
+//	-r		write the frames to standard output as raw frames, like SaveEnd's
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+int main(int argc, char **argv) {
+	DeltaReader *d;
+	const VGubyte *frame;
+	char *prefix = NULL, name[1024];
+	int c, raw = 0, w, h, flags, n, status = 0;
+
+	while ((c = getopt(argc, argv, "p:r")) != -1) {
+		switch (c) {
+		case 'p':
+			prefix = optarg;
+			break;
+		case 'r':
+			raw = 1;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-p prefix] [-r] file\n", argv[0]);
+			exit(1);
+		}
+	}
+	if (optind != argc - 1 || (prefix == NULL && !raw)) {
+		fprintf(stderr, "usage: %s [-p prefix] [-r] file\n", argv[0]);
+		exit(1);
+	}
+	d = DeltaOpen(argv[optind], &w, &h, &flags);
+	if (d == NULL) {
+		fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[optind]);
+		exit(1);
+	}
+	for (n = 0; (frame = DeltaNext(d)) != NULL; n++) {
+		if (prefix != NULL) {
+			snprintf(name, sizeof(name), "%s-%05d.png", prefix, n);
+			if (WritePNG(name, frame, w, h, w * 4, flags & CAPTURE_TOPDOWN) != 0) {
+				fprintf(stderr, "%s: cannot write %s\n", argv[0], name);
+				status = 1;
+				break;
+			}
+		}
+		if (raw && fwrite(frame, (size_t) w * h * 4, 1, stdout) != 1) {
+			fprintf(stderr, "%s: write error\n", argv[0]);
+			status = 1;
+			break;
+		}
+	}
+	if (status == 0 && n == 0) {
+		fprintf(stderr, "%s: no frames in %s\n", argv[0], argv[optind]);
+		status = 1;
+	}
+	DeltaClose(d);
+	fprintf(stderr, "%d frames, %dx%d\n", n, w, h);
+	exit(status);
+}
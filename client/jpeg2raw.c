@@ -0,0 +1,33 @@
+// jpeg2raw: decode JPEG files once, to raw image files that load without decoding
+// usage: jpeg2raw file.jpg... (writes file.raw for each)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+int main(int argc, char **argv) {
+	char raw[1024];
+	char *dot;
+	int i, status = 0;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s file.jpg...\n", argv[0]);
+		exit(1);
+	}
+	for (i = 1; i < argc; i++) {
+		snprintf(raw, sizeof(raw), "%s", argv[i]);
+		dot = strrchr(raw, '.');
+		if (dot != NULL && strchr(dot, '/') == NULL) {
+			*dot = '\0';
+		}
+		strncat(raw, ".raw", sizeof(raw) - strlen(raw) - 1);
+		if (RawImageFromJpeg(argv[i], raw) != 0) {
+			fprintf(stderr, "%s: cannot convert %s\n", argv[0], argv[i]);
+			status = 1;
+		}
+	}
+	exit(status);
+}
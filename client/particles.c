@@ -6,6 +6,7 @@
 //
 // Options:
 //  -t  show trails
+//  -s  print frame statistics
 //
 //  -r  right-to-left only  (direction alternates by default)
 //  -l  left-to-right only
@@ -33,6 +34,7 @@ typedef struct particle {
 particle_t particles[NUM_PARTICLES];
 
 int showTrails = 0;
+int showStats = 0;
 int directionRTL = 0;
 int alternate = 1;
 double gravity = 0.5;
@@ -125,6 +127,9 @@ void setOptions(int argc, char **argv) {
 			showTrails = 1;
 			printf("Displaying trails\n");
 		}
+		if (option == 's') {
+			showStats = 1;
+		}
 		// If r or l is set, disable alternation
 		if (option == 'r' || option == 'l')
 			alternate = 0;
@@ -148,6 +153,7 @@ void setOptions(int argc, char **argv) {
 
 // Display Options
 // -t  show trails
+// -s  print frame statistics
 // -g[value] gravity
 //
 // Direction (alternates by default)
@@ -164,17 +170,29 @@ int main(int argc, char **argv) {
 
 	Start(w, h);
 
-	int i = 0;
+	// End waits for the next vertical sync (or 60 a second), rather than tie up the CPU
+	if (FrameVsync(1) != 0) {
+		FrameRate(60);
+	}
+
+	int i = 0, n = 0;
 	while (1) {
 		draw(w, h);
 
-		// NOTE: Consider a `usleep()` in here to not tie up the CPU if you intend serious use
-
 		// Change launch direction every 100 draws
 		i++;
 		if (alternate && i == 100) {
 			directionRTL = directionRTL ? 0 : 1;
 			i = 0;
 		}
+		// Report the last few seconds every 100 draws
+		if (showStats && ++n == 100) {
+			FrameStats fs;
+			FrameStatsRead(&fs);
+			printf("%.1f fps, draw %.1f ms, swap %.1f ms, worst frame %.1f ms, %d janks\n",
+			       fs.interval.mean > 0 ? 1000 / fs.interval.mean : 0, fs.cpu.mean, fs.swap.mean,
+			       fs.interval.max, fs.recentjanks);
+			n = 0;
+		}
 	}
 }
@@ -0,0 +1,72 @@
+// sharewatch: read the frames another program publishes with ShareOpen, without copies
+// usage: sharewatch [-n frames] [-p prefix] name
+//	prints each frame's number and Adler-32 checksum, and the frames missed;
+//	-p prefix	also write each frame as prefix-00000.png, prefix-00001.png, ...
+//	-n frames	stop after this many frames (default: until no frame comes for 5 seconds)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+int main(int argc, char **argv) {
+	FrameShare *s;
+	const VGubyte *frame;
+	unsigned long seq = 0, last = 0, missed = 0, torn = 0;
+	uLong sum;
+	char *prefix = NULL, name[1024];
+	int c, w, h, flags, n = 0, limit = -1;
+
+	while ((c = getopt(argc, argv, "n:p:")) != -1) {
+		switch (c) {
+		case 'n':
+			limit = atoi(optarg);
+			break;
+		case 'p':
+			prefix = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n frames] [-p prefix] name\n", argv[0]);
+			exit(1);
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr, "usage: %s [-n frames] [-p prefix] name\n", argv[0]);
+		exit(1);
+	}
+	s = ShareAttach(argv[optind], &w, &h, &flags);
+	if (s == NULL) {
+		fprintf(stderr, "%s: cannot attach to %s\n", argv[0], argv[optind]);
+		exit(1);
+	}
+	while (n != limit && (frame = ShareNext(s, &seq, 5000)) != NULL) {
+		sum = adler32(adler32(0L, Z_NULL, 0), frame, (uInt) w * h * 4);
+		if (prefix != NULL) {
+			snprintf(name, sizeof(name), "%s-%05d.png", prefix, n);
+			if (WritePNG(name, frame, w, h, w * 4, flags & CAPTURE_TOPDOWN) != 0) {
+				fprintf(stderr, "%s: cannot write %s\n", argv[0], name);
+				break;
+			}
+		}
+		if (!ShareCheck(s, seq)) {
+			torn++;				   // overwritten while read; the next is newer
+			if (prefix != NULL) {
+				unlink(name);
+			}
+			continue;
+		}
+		if (last != 0 && seq > last + 1) {
+			missed += seq - last - 1;
+		}
+		last = seq;
+		printf("%lu %08lx\n", seq, sum);
+		n++;
+	}
+	ShareClose(s);
+	fprintf(stderr, "%d frames, %dx%d, %lu missed, %lu overwritten while read\n", n, w, h, missed, torn);
+	exit(0);
+}
@@ -0,0 +1,423 @@
+//
+// cmdbuf: drawing command buffers
+//
+// A command buffer is a sequence of 32 bit words: an opcode (CMD_*
+// in shapes.h), then its arguments. Bindings from other languages
+// record a frame's drawing into one, and draw it with a single call.
+// In retained mode, each frame's buffer is compared with the last, and
+// the window area of the commands that changed is marked for redrawing.
+//
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+// cmdargs is the number of argument words for the fixed size commands
+static const signed char cmdargs[CMD_COUNT] = {
+	[CMD_RECT] = 4,
+	[CMD_ROUNDRECT] = 6,
+	[CMD_ELLIPSE] = 4,
+	[CMD_CIRCLE] = 3,
+	[CMD_LINE] = 4,
+	[CMD_ARC] = 6,
+	[CMD_QBEZIER] = 6,
+	[CMD_CBEZIER] = 8,
+	[CMD_FILL] = 4,
+	[CMD_STROKE] = 4,
+	[CMD_STROKEWIDTH] = 1,
+	[CMD_TRANSLATE] = 2,
+	[CMD_ROTATE] = 1,
+	[CMD_SCALE] = 2,
+	[CMD_SHEAR] = 2,
+	[CMD_BACKGROUND] = 4,
+	[CMD_CLIPRECT] = 4,
+	[CMD_CLIPEND] = 0,
+};
+
+// cmdfont returns the font numbered in a text command
+static Fontinfo *cmdfont(int n) {
+	switch (n) {
+	case CMD_FONT_SANS:
+		return &SansTypeface;
+	case CMD_FONT_MONO:
+		return &MonoTypeface;
+	}
+	return &SerifTypeface;
+}
+
+// DrawCommands draws the n words of a command buffer. Drawing stops at an unknown
+// opcode, or a command that runs past the end of the buffer.
+void DrawCommands(const VGint * cmd, int n) {
+	const VGint *end = cmd + n;
+	const VGfloat *poly;
+	VGfloat a[8];
+	VGint op, k;
+	Fontinfo *f;
+
+	while (cmd < end) {
+		op = *cmd++;
+		switch (op) {
+		case CMD_POLYGON:			   // count, x values, y values
+		case CMD_POLYLINE:
+			if (cmd >= end || cmd[0] < 0 || cmd[0] > (end - cmd - 1) / 2) {
+				return;
+			}
+			k = *cmd++;
+			poly = (const VGfloat *)cmd;
+			if (op == CMD_POLYGON) {
+				Polygon((VGfloat *) poly, (VGfloat *) poly + k, k);
+			} else {
+				Polyline((VGfloat *) poly, (VGfloat *) poly + k, k);
+			}
+			cmd += 2 * k;
+			continue;
+		case CMD_TEXT:				   // font, size, alignment, x, y, words of text, text with a NUL
+			if (end - cmd < 6 || cmd[5] < 0 || cmd[5] > end - cmd - 6) {
+				return;
+			}
+			memcpy(a, cmd + 3, 2 * sizeof(VGfloat));
+			f = cmdfont(cmd[0]);
+			k = cmd[5];
+			if (k > 0 && ((const char *)(cmd + 6))[k * 4 - 1] == '\0') {
+				switch (cmd[2]) {
+				case CMD_ALIGN_MID:
+					TextMid(a[0], a[1], (const char *)(cmd + 6), *f, cmd[1]);
+					break;
+				case CMD_ALIGN_END:
+					TextEnd(a[0], a[1], (const char *)(cmd + 6), *f, cmd[1]);
+					break;
+				default:
+					Text(a[0], a[1], (const char *)(cmd + 6), *f, cmd[1]);
+				}
+			}
+			cmd += 6 + k;
+			continue;
+		}
+		if (op <= 0 || op >= CMD_COUNT || end - cmd < cmdargs[op]) {
+			return;
+		}
+		memcpy(a, cmd, cmdargs[op] * sizeof(VGfloat));
+		cmd += cmdargs[op];
+		switch (op) {
+		case CMD_RECT:
+			Rect(a[0], a[1], a[2], a[3]);
+			break;
+		case CMD_ROUNDRECT:
+			Roundrect(a[0], a[1], a[2], a[3], a[4], a[5]);
+			break;
+		case CMD_ELLIPSE:
+			Ellipse(a[0], a[1], a[2], a[3]);
+			break;
+		case CMD_CIRCLE:
+			Circle(a[0], a[1], a[2]);
+			break;
+		case CMD_LINE:
+			Line(a[0], a[1], a[2], a[3]);
+			break;
+		case CMD_ARC:
+			Arc(a[0], a[1], a[2], a[3], a[4], a[5]);
+			break;
+		case CMD_QBEZIER:
+			Qbezier(a[0], a[1], a[2], a[3], a[4], a[5]);
+			break;
+		case CMD_CBEZIER:
+			Cbezier(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+			break;
+		case CMD_FILL:				   // red, green, blue 0..255, alpha 0..1
+			Fill(a[0], a[1], a[2], a[3]);
+			break;
+		case CMD_STROKE:
+			Stroke(a[0], a[1], a[2], a[3]);
+			break;
+		case CMD_STROKEWIDTH:
+			StrokeWidth(a[0]);
+			break;
+		case CMD_TRANSLATE:
+			Translate(a[0], a[1]);
+			break;
+		case CMD_ROTATE:
+			Rotate(a[0]);
+			break;
+		case CMD_SCALE:
+			Scale(a[0], a[1]);
+			break;
+		case CMD_SHEAR:
+			Shear(a[0], a[1]);
+			break;
+		case CMD_BACKGROUND:
+			BackgroundRGB(a[0], a[1], a[2], a[3]);
+			break;
+		case CMD_CLIPRECT:
+			ClipRect(a[0], a[1], a[2], a[3]);
+			break;
+		case CMD_CLIPEND:
+			ClipEnd();
+			break;
+		}
+	}
+}
+
+//
+// Retained mode
+//
+
+// Item is a drawing command of a frame
+typedef struct {
+	uint32_t hash;					   // of the command, and the state it is drawn in
+	VGfloat box[4];					   // window area: x0 y0 x1 y1
+} Item;
+
+struct Retained {
+	Item *items;					   // this frame's
+	int nitems, size;
+	Item *prev;					   // the last frame's
+	int nprev, prevsize;
+	int seen;					   // there was a last frame
+};
+
+// DrawState is the drawing state a command is drawn in
+typedef struct {
+	VGfloat fill[4], stroke[4], width;
+	VGfloat m[6];					   // user to window: x' = m0 x + m2 y + m4, y' = m1 x + m3 y + m5
+	VGfloat clip[4];				   // zero width when not clipping
+} DrawState;
+
+// fnv hashes n bytes into h
+static uint32_t fnv(uint32_t h, const void *p, size_t n) {
+	const unsigned char *b = (const unsigned char *)p;
+
+	while (n-- > 0) {
+		h = (h ^ *b++) * 16777619u;
+	}
+	return h;
+}
+
+// additem adds a command's item, its area the user space box x0,y0 to x1,y1
+// (grown by the stroke, for the joins), in the state's transformation
+static int additem(Retained * r, const DrawState * st, const VGint * cmd, int n, VGfloat x0, VGfloat y0, VGfloat x1,
+		   VGfloat y1, int transform) {
+	VGfloat pad = st->width * 2, x, y;
+	VGfloat cx[4], cy[4];
+	Item *it;
+	int i;
+
+	if (r->nitems == r->size) {
+		it = (Item *) realloc(r->items, (r->size * 2 + 64) * sizeof(Item));
+		if (it == NULL) {
+			InvalidateWindow();		   // the item is not kept, so assume everything changed
+			return -1;
+		}
+		r->items = it;
+		r->size = r->size * 2 + 64;
+	}
+	it = &r->items[r->nitems++];
+	it->hash = fnv(fnv(2166136261u, cmd, n * sizeof(VGint)), st, sizeof(DrawState));
+	if (!transform) {
+		it->box[0] = x0, it->box[1] = y0, it->box[2] = x1, it->box[3] = y1;
+		return 0;
+	}
+	cx[0] = cx[3] = (x0 < x1 ? x0 : x1) - pad;
+	cx[1] = cx[2] = (x0 < x1 ? x1 : x0) + pad;
+	cy[0] = cy[1] = (y0 < y1 ? y0 : y1) - pad;
+	cy[2] = cy[3] = (y0 < y1 ? y1 : y0) + pad;
+	for (i = 0; i < 4; i++) {
+		x = st->m[0] * cx[i] + st->m[2] * cy[i] + st->m[4];
+		y = st->m[1] * cx[i] + st->m[3] * cy[i] + st->m[5];
+		if (i == 0 || x < it->box[0]) {
+			it->box[0] = x;
+		}
+		if (i == 0 || y < it->box[1]) {
+			it->box[1] = y;
+		}
+		if (i == 0 || x > it->box[2]) {
+			it->box[2] = x;
+		}
+		if (i == 0 || y > it->box[3]) {
+			it->box[3] = y;
+		}
+	}
+	return 0;
+}
+
+// RetainedOpen makes a retained mode drawing, to find what changes from frame to frame
+Retained *RetainedOpen() {
+	return (Retained *) calloc(1, sizeof(Retained));
+}
+
+// RetainedDamage compares a frame's n words of commands with the last frame's, and invalidates
+// the window area of the commands that changed (the whole window for the first frame).
+// Draw the frame with StartDamaged, DrawCommands and End; only the invalidated area is redrawn.
+void RetainedDamage(Retained * r, const VGint * cmd, int n) {
+	const VGint *start, *end = cmd + n;
+	const VGfloat *px, *py;
+	DrawState st;
+	VGfloat a[8], x0, y0, x1, y1, w, c, sn, m[4];
+	VGint op, k;
+	Fontinfo *f;
+	Item *t;
+	int i, ts;
+
+	memset(&st, 0, sizeof(st));			   // as Start leaves it
+	st.fill[3] = st.stroke[3] = 1;
+	st.m[0] = st.m[3] = 1;
+	r->nitems = 0;
+	while (cmd < end) {
+		start = cmd;
+		op = *cmd++;
+		switch (op) {
+		case CMD_POLYGON:
+		case CMD_POLYLINE:
+			if (cmd >= end || cmd[0] < 0 || cmd[0] > (end - cmd - 1) / 2) {
+				cmd = end;
+				continue;
+			}
+			k = *cmd++;
+			px = (const VGfloat *)cmd;
+			py = px + k;
+			cmd += 2 * k;
+			if (k == 0) {
+				continue;
+			}
+			x0 = x1 = px[0];
+			y0 = y1 = py[0];
+			for (i = 1; i < k; i++) {
+				x0 = px[i] < x0 ? px[i] : x0;
+				x1 = px[i] > x1 ? px[i] : x1;
+				y0 = py[i] < y0 ? py[i] : y0;
+				y1 = py[i] > y1 ? py[i] : y1;
+			}
+			additem(r, &st, start, cmd - start, x0, y0, x1, y1, 1);
+			continue;
+		case CMD_TEXT:
+			if (end - cmd < 6 || cmd[5] < 0 || cmd[5] > end - cmd - 6) {
+				cmd = end;
+				continue;
+			}
+			k = cmd[5];
+			if (k > 0 && ((const char *)(cmd + 6))[k * 4 - 1] == '\0') {
+				memcpy(a, cmd + 3, 2 * sizeof(VGfloat));
+				f = cmdfont(cmd[0]);
+				w = TextWidth((const char *)(cmd + 6), *f, cmd[1]);
+				x0 = a[0] - (cmd[2] == CMD_ALIGN_MID ? w / 2 : cmd[2] == CMD_ALIGN_END ? w : 0);
+				// glyphs may reach a little past their advance and the font's height
+				additem(r, &st, start, 7 + k, x0 - cmd[1] / 4, a[1] - TextDepth(*f, cmd[1]) - cmd[1] / 4,
+					x0 + w + cmd[1] / 4, a[1] + TextHeight(*f, cmd[1]) + cmd[1] / 4, 1);
+			}
+			cmd += 6 + k;
+			continue;
+		}
+		if (op <= 0 || op >= CMD_COUNT || end - cmd < cmdargs[op]) {
+			break;
+		}
+		memcpy(a, cmd, cmdargs[op] * sizeof(VGfloat));
+		cmd += cmdargs[op];
+		switch (op) {
+		case CMD_RECT:
+		case CMD_ROUNDRECT:
+			additem(r, &st, start, cmd - start, a[0], a[1], a[0] + a[2], a[1] + a[3], 1);
+			break;
+		case CMD_ELLIPSE:
+		case CMD_ARC:				   // centered on x, y
+			additem(r, &st, start, cmd - start, a[0] - a[2] / 2, a[1] - a[3] / 2, a[0] + a[2] / 2, a[1] + a[3] / 2, 1);
+			break;
+		case CMD_CIRCLE:			   // the size is the diameter
+			additem(r, &st, start, cmd - start, a[0] - a[2] / 2, a[1] - a[2] / 2, a[0] + a[2] / 2, a[1] + a[2] / 2, 1);
+			break;
+		case CMD_LINE:
+		case CMD_QBEZIER:			   // within the control points
+		case CMD_CBEZIER:
+			x0 = x1 = a[0];
+			y0 = y1 = a[1];
+			for (i = 2; i < cmdargs[op]; i += 2) {
+				x0 = a[i] < x0 ? a[i] : x0;
+				x1 = a[i] > x1 ? a[i] : x1;
+				y0 = a[i + 1] < y0 ? a[i + 1] : y0;
+				y1 = a[i + 1] > y1 ? a[i + 1] : y1;
+			}
+			additem(r, &st, start, cmd - start, x0, y0, x1, y1, 1);
+			break;
+		case CMD_BACKGROUND:			   // the whole window
+			additem(r, &st, start, cmd - start, 0, 0, 65536, 65536, 0);
+			break;
+		case CMD_FILL:
+			memcpy(st.fill, a, sizeof(st.fill));
+			break;
+		case CMD_STROKE:
+			memcpy(st.stroke, a, sizeof(st.stroke));
+			break;
+		case CMD_STROKEWIDTH:
+			st.width = a[0];
+			break;
+		case CMD_TRANSLATE:			   // as OpenVG, applied before the transformation so far
+			st.m[4] += st.m[0] * a[0] + st.m[2] * a[1];
+			st.m[5] += st.m[1] * a[0] + st.m[3] * a[1];
+			break;
+		case CMD_ROTATE:
+			c = cosf(a[0] * M_PI / 180);
+			sn = sinf(a[0] * M_PI / 180);
+			memcpy(m, st.m, sizeof(m));
+			st.m[0] = m[0] * c + m[2] * sn;
+			st.m[1] = m[1] * c + m[3] * sn;
+			st.m[2] = m[2] * c - m[0] * sn;
+			st.m[3] = m[3] * c - m[1] * sn;
+			break;
+		case CMD_SCALE:
+			st.m[0] *= a[0];
+			st.m[1] *= a[0];
+			st.m[2] *= a[1];
+			st.m[3] *= a[1];
+			break;
+		case CMD_SHEAR:
+			memcpy(m, st.m, sizeof(m));
+			st.m[0] = m[0] + m[2] * a[1];
+			st.m[1] = m[1] + m[3] * a[1];
+			st.m[2] = m[2] + m[0] * a[0];
+			st.m[3] = m[3] + m[1] * a[0];
+			break;
+		case CMD_CLIPRECT:			   // part of the state of what follows
+			memcpy(st.clip, a, sizeof(st.clip));
+			break;
+		case CMD_CLIPEND:
+			memset(st.clip, 0, sizeof(st.clip));
+			break;
+		}
+	}
+
+	if (!r->seen) {
+		InvalidateWindow();
+	} else {
+		for (i = 0; i < r->nitems || i < r->nprev; i++) {
+			if (i < r->nitems && i < r->nprev && r->items[i].hash == r->prev[i].hash
+			    && memcmp(r->items[i].box, r->prev[i].box, sizeof(r->items[i].box)) == 0) {
+				continue;
+			}
+			if (i < r->nprev) {
+				t = &r->prev[i];
+				InvalidateRect(t->box[0], t->box[1], t->box[2] - t->box[0], t->box[3] - t->box[1]);
+			}
+			if (i < r->nitems) {
+				t = &r->items[i];
+				InvalidateRect(t->box[0], t->box[1], t->box[2] - t->box[0], t->box[3] - t->box[1]);
+			}
+		}
+	}
+	r->seen = 1;
+	t = r->prev, r->prev = r->items, r->items = t;
+	ts = r->prevsize, r->prevsize = r->size, r->size = ts;
+	r->nprev = r->nitems;
+	r->nitems = 0;
+}
+
+// RetainedClose frees a retained mode drawing
+void RetainedClose(Retained * r) {
+	if (r == NULL) {
+		return;
+	}
+	free(r->items);
+	free(r->prev);
+	free(r);
+}
@@ -0,0 +1,188 @@
+// Code generated by mkcolorhash from go-client/colortab/svgcolors.txt; DO NOT EDIT.
+
+package openvg
+
+const (
+	colorbuckets = 64
+	colorslots   = 256
+)
+
+// colorhash is a seeded FNV-1a hash
+func colorhash(seed uint32, s string) uint32 {
+	h := 2166136261 ^ seed*0x9e3779b9
+	for i := 0; i < len(s); i++ {
+		h ^= uint32(s[i])
+		h *= 16777619
+	}
+	h ^= h >> 15
+	h *= 0x2c1b3c6d
+	return h ^ h>>12
+}
+
+// colorseeds holds the second hash seed of each bucket
+var colorseeds = [colorbuckets]uint32{
+	3, 1, 4, 1, 1, 11, 2, 2, 5, 0, 2, 2, 1, 0, 0, 1,
+	0, 6, 1, 2, 5, 2, 3, 1, 1, 5, 2, 1, 2, 1, 3, 1,
+	2, 3, 1, 4, 1, 5, 1, 3, 2, 2, 2, 2, 1, 2, 1, 1,
+	3, 5, 2, 3, 0, 1, 1, 1, 1, 2, 2, 2, 3, 0, 1, 6,
+}
+
+// colortable holds the SVG colors by slot
+var colortable = [colorslots]struct {
+	name string
+	RGB
+}{
+	0:   {"slateblue", RGB{106, 90, 205}},
+	4:   {"wheat", RGB{245, 222, 179}},
+	5:   {"mistyrose", RGB{255, 228, 225}},
+	7:   {"mediumblue", RGB{0, 0, 205}},
+	9:   {"darkgrey", RGB{169, 169, 169}},
+	10:  {"lavender", RGB{230, 230, 250}},
+	12:  {"lightgoldenrodyellow", RGB{250, 250, 210}},
+	14:  {"palevioletred", RGB{219, 112, 147}},
+	18:  {"deeppink", RGB{255, 20, 147}},
+	19:  {"lightpink", RGB{255, 182, 193}},
+	20:  {"bisque", RGB{255, 228, 196}},
+	23:  {"black", RGB{0, 0, 0}},
+	24:  {"blue", RGB{0, 0, 255}},
+	25:  {"red", RGB{255, 0, 0}},
+	26:  {"limegreen", RGB{50, 205, 50}},
+	28:  {"dimgray", RGB{105, 105, 105}},
+	29:  {"dodgerblue", RGB{30, 144, 255}},
+	30:  {"mintcream", RGB{245, 255, 250}},
+	33:  {"lightgrey", RGB{211, 211, 211}},
+	34:  {"olivedrab", RGB{107, 142, 35}},
+	38:  {"lightseagreen", RGB{32, 178, 170}},
+	40:  {"papayawhip", RGB{255, 239, 213}},
+	42:  {"salmon", RGB{250, 128, 114}},
+	44:  {"lavenderblush", RGB{255, 240, 245}},
+	46:  {"brown", RGB{165, 42, 42}},
+	47:  {"dimgrey", RGB{105, 105, 105}},
+	48:  {"lightskyblue", RGB{135, 206, 250}},
+	49:  {"linen", RGB{250, 240, 230}},
+	51:  {"mediumorchid", RGB{186, 85, 211}},
+	52:  {"aqua", RGB{0, 255, 255}},
+	54:  {"indigo", RGB{75, 0, 130}},
+	55:  {"thistle", RGB{216, 191, 216}},
+	56:  {"lightslategray", RGB{119, 136, 153}},
+	57:  {"whitesmoke", RGB{245, 245, 245}},
+	58:  {"orangered", RGB{255, 69, 0}},
+	59:  {"seashell", RGB{255, 245, 238}},
+	60:  {"purple", RGB{128, 0, 128}},
+	61:  {"honeydew", RGB{240, 255, 240}},
+	63:  {"turquoise", RGB{64, 224, 208}},
+	64:  {"midnightblue", RGB{25, 25, 112}},
+	66:  {"tomato", RGB{255, 99, 71}},
+	68:  {"darksalmon", RGB{233, 150, 122}},
+	69:  {"teal", RGB{0, 128, 128}},
+	71:  {"chocolate", RGB{210, 105, 30}},
+	72:  {"magenta", RGB{255, 0, 255}},
+	73:  {"darkslateblue", RGB{72, 61, 139}},
+	78:  {"darkolivegreen", RGB{85, 107, 47}},
+	79:  {"silver", RGB{192, 192, 192}},
+	86:  {"fuchsia", RGB{255, 0, 255}},
+	88:  {"steelblue", RGB{70, 130, 180}},
+	89:  {"darkorange", RGB{255, 140, 0}},
+	90:  {"yellow", RGB{255, 255, 0}},
+	91:  {"maroon", RGB{128, 0, 0}},
+	93:  {"darkblue", RGB{0, 0, 139}},
+	99:  {"lightgray", RGB{211, 211, 211}},
+	102: {"darkslategrey", RGB{47, 79, 79}},
+	103: {"lightcyan", RGB{224, 255, 255}},
+	104: {"palegoldenrod", RGB{238, 232, 170}},
+	105: {"sienna", RGB{160, 82, 45}},
+	107: {"plum", RGB{221, 160, 221}},
+	108: {"moccasin", RGB{255, 228, 181}},
+	109: {"lightblue", RGB{173, 216, 230}},
+	112: {"darkgreen", RGB{0, 100, 0}},
+	113: {"darkslategray", RGB{47, 79, 79}},
+	114: {"darkkhaki", RGB{189, 183, 107}},
+	115: {"darkgoldenrod", RGB{184, 134, 11}},
+	117: {"lime", RGB{0, 255, 0}},
+	118: {"navy", RGB{0, 0, 128}},
+	120: {"slategray", RGB{112, 128, 144}},
+	124: {"mediumturquoise", RGB{72, 209, 204}},
+	133: {"green", RGB{0, 128, 0}},
+	134: {"lightgreen", RGB{144, 238, 144}},
+	136: {"gold", RGB{255, 215, 0}},
+	138: {"blueviolet", RGB{138, 43, 226}},
+	139: {"beige", RGB{245, 245, 220}},
+	141: {"skyblue", RGB{135, 206, 235}},
+	142: {"rosybrown", RGB{188, 143, 143}},
+	143: {"coral", RGB{255, 127, 80}},
+	144: {"gray", RGB{128, 128, 128}},
+	146: {"lightcoral", RGB{240, 128, 128}},
+	147: {"ghostwhite", RGB{248, 248, 255}},
+	149: {"lightsteelblue", RGB{176, 196, 222}},
+	150: {"orange", RGB{255, 165, 0}},
+	151: {"orchid", RGB{218, 112, 214}},
+	152: {"hotpink", RGB{255, 105, 180}},
+	153: {"darkorchid", RGB{153, 50, 204}},
+	154: {"darkcyan", RGB{0, 139, 139}},
+	155: {"oldlace", RGB{253, 245, 230}},
+	157: {"peachpuff", RGB{255, 218, 185}},
+	158: {"olive", RGB{128, 128, 0}},
+	161: {"mediumpurple", RGB{147, 112, 219}},
+	163: {"aliceblue", RGB{240, 248, 255}},
+	165: {"cadetblue", RGB{95, 158, 160}},
+	166: {"peru", RGB{205, 133, 63}},
+	169: {"violet", RGB{238, 130, 238}},
+	172: {"antiquewhite", RGB{250, 235, 215}},
+	173: {"mediumvioletred", RGB{199, 21, 133}},
+	174: {"darkturquoise", RGB{0, 206, 209}},
+	175: {"chartreuse", RGB{127, 255, 0}},
+	178: {"darkmagenta", RGB{139, 0, 139}},
+	179: {"floralwhite", RGB{255, 250, 240}},
+	182: {"mediumspringgreen", RGB{0, 250, 154}},
+	185: {"lightslategrey", RGB{119, 136, 153}},
+	186: {"sandybrown", RGB{244, 164, 96}},
+	188: {"greenyellow", RGB{173, 255, 47}},
+	189: {"darkseagreen", RGB{143, 188, 143}},
+	191: {"blanchedalmond", RGB{255, 235, 205}},
+	193: {"azure", RGB{240, 255, 255}},
+	194: {"grey", RGB{128, 128, 128}},
+	198: {"palegreen", RGB{152, 251, 152}},
+	200: {"white", RGB{255, 255, 255}},
+	201: {"saddlebrown", RGB{139, 69, 19}},
+	202: {"springgreen", RGB{0, 255, 127}},
+	204: {"mediumseagreen", RGB{60, 179, 113}},
+	205: {"lawngreen", RGB{124, 252, 0}},
+	207: {"royalblue", RGB{65, 105, 225}},
+	208: {"mediumslateblue", RGB{123, 104, 238}},
+	212: {"goldenrod", RGB{218, 165, 32}},
+	216: {"snow", RGB{255, 250, 250}},
+	217: {"aquamarine", RGB{127, 255, 212}},
+	218: {"cornsilk", RGB{255, 248, 220}},
+	220: {"yellowgreen", RGB{154, 205, 50}},
+	222: {"seagreen", RGB{46, 139, 87}},
+	223: {"lightyellow", RGB{255, 255, 224}},
+	224: {"deepskyblue", RGB{0, 191, 255}},
+	225: {"powderblue", RGB{176, 224, 230}},
+	226: {"cyan", RGB{0, 255, 255}},
+	229: {"paleturquoise", RGB{175, 238, 238}},
+	230: {"slategrey", RGB{112, 128, 144}},
+	231: {"firebrick", RGB{178, 34, 34}},
+	232: {"ivory", RGB{255, 255, 240}},
+	233: {"burlywood", RGB{222, 184, 135}},
+	234: {"darkviolet", RGB{148, 0, 211}},
+	235: {"darkgray", RGB{169, 169, 169}},
+	236: {"lightsalmon", RGB{255, 160, 122}},
+	238: {"navajowhite", RGB{255, 222, 173}},
+	239: {"indianred", RGB{205, 92, 92}},
+	240: {"lemonchiffon", RGB{255, 250, 205}},
+	242: {"khaki", RGB{240, 230, 140}},
+	245: {"crimson", RGB{220, 20, 60}},
+	246: {"mediumaquamarine", RGB{102, 205, 170}},
+	247: {"pink", RGB{255, 192, 203}},
+	248: {"forestgreen", RGB{34, 139, 34}},
+	250: {"gainsboro", RGB{220, 220, 220}},
+	251: {"darkred", RGB{139, 0, 0}},
+	252: {"tan", RGB{210, 180, 140}},
+	253: {"cornflowerblue", RGB{100, 149, 237}},
+}
+
+// svgcolor returns the named SVG color
+func svgcolor(s string) (RGB, bool) {
+	e := &colortable[colorhash(colorseeds[colorhash(0, s)%colorbuckets], s)%colorslots]
+	return e.RGB, e.name == s && s != ""
+}
@@ -0,0 +1,258 @@
+//
+// delta: delta compressed frame recordings
+//
+// A recording is a header, then frames, each a record type, the
+// payload length in bytes, and the payload. A keyframe is the whole
+// frame, run length encoded; a delta frame is the runs of rows that
+// changed since the previous frame, each stored as the XOR with the
+// previous frame, run length encoded, so unchanged pixels are long
+// runs of zero. A frame with nothing changed is 8 bytes.
+//
+// All words are 32 bit, in the byte order of the machine that wrote them:
+//
+//	header:	"VGDL" version width height flags (CAPTURE_ flags) 3 reserved words
+//	frame:	type (DELTA_KEY or DELTA_ROWS) length payload
+//	DELTA_KEY payload:	RLE of width*height pixels
+//	DELTA_ROWS payload:	zero or more of: first row, row count, RLE of row count*width pixels
+//	RLE:	packets of a count word, then if the count has the top bit set, one pixel
+//		repeated count&0x7fffffff times, otherwise count pixels
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+#define DELTA_MAGIC	"VGDL"
+#define DELTA_VERSION	1
+#define DELTA_KEY	1
+#define DELTA_ROWS	2
+#define RLE_RUN		0x80000000u
+#define RLE_MAX		0x7fffffffu
+
+// pixel i of a, XORed with b if there is one
+#define PX(i) (b != NULL ? a[i] ^ b[i] : a[i])
+
+// rle encodes n pixels of a (XORed with b, if not NULL) into out, returning the words written.
+// Runs of three or more pixels are packed; the output is at most one word longer than the input.
+static size_t rle(uint32_t * out, const uint32_t * a, const uint32_t * b, size_t n) {
+	uint32_t *o = out, p;
+	size_t i = 0, j, run;
+
+	while (i < n) {
+		p = PX(i);
+		for (run = 1; i + run < n && run < RLE_MAX && PX(i + run) == p; run++) {
+		}
+		if (run >= 3) {
+			*o++ = RLE_RUN | run;
+			*o++ = p;
+			i += run;
+			continue;
+		}
+		// literal, up to the start of the next run of three
+		for (j = i + run; j < n && j - i < RLE_MAX; j++) {
+			if (j + 2 < n && PX(j) == PX(j + 1) && PX(j) == PX(j + 2)) {
+				break;
+			}
+		}
+		*o++ = j - i;
+		for (; i < j; i++) {
+			*o++ = PX(i);
+		}
+	}
+	return o - out;
+}
+
+// unrle decodes n pixels from the words at in into dst, XORing with dst's pixels if xor is set.
+// Returns the words read, or 0 if the data is malformed.
+static size_t unrle(uint32_t * dst, const uint32_t * in, size_t inwords, size_t n, int xor) {
+	const uint32_t *p = in, *end = in + inwords;
+	size_t count, k;
+
+	while (n > 0) {
+		if (p >= end) {
+			return 0;
+		}
+		count = *p & RLE_MAX;
+		if (count == 0 || count > n) {
+			return 0;
+		}
+		if (*p++ & RLE_RUN) {
+			if (p >= end) {
+				return 0;
+			}
+			for (k = 0; k < count; k++) {
+				dst[k] = xor ? dst[k] ^ *p : *p;
+			}
+			p++;
+		} else {
+			if ((size_t) (end - p) < count) {
+				return 0;
+			}
+			for (k = 0; k < count; k++) {
+				dst[k] = xor ? dst[k] ^ p[k] : p[k];
+			}
+			p += count;
+		}
+		dst += count;
+		n -= count;
+	}
+	return p - in;
+}
+
+// DeltaHeader fills the DELTA_HEADER bytes that begin a recording of w x h frames
+void DeltaHeader(VGubyte * out, int w, int h, int flags) {
+	uint32_t hdr[DELTA_HEADER / 4];
+
+	memset(hdr, 0, sizeof(hdr));
+	memcpy(hdr, DELTA_MAGIC, 4);
+	hdr[1] = DELTA_VERSION;
+	hdr[2] = w;
+	hdr[3] = h;
+	hdr[4] = flags;
+	memcpy(out, hdr, sizeof(hdr));
+}
+
+// DeltaBound returns the largest size of an encoded w x h frame
+size_t DeltaBound(int w, int h) {
+	return (size_t) w * h * 4 + (size_t) h * 12 + 16;
+}
+
+// DeltaEncode encodes a w x h frame into out (DeltaBound bytes, 4 byte aligned), as the changes
+// from prev, or as a keyframe if prev is NULL. Returns the bytes written.
+size_t DeltaEncode(VGubyte * out, const VGubyte * frame, const VGubyte * prev, int w, int h) {
+	uint32_t *o = (uint32_t *) out;
+	const uint32_t *a = (const uint32_t *)frame, *b = (const uint32_t *)prev;
+	size_t rowbytes = (size_t) w * 4, n = 2;
+	int y, y0;
+
+	if (prev == NULL) {
+		n += rle(o + 2, a, NULL, (size_t) w * h);
+		o[0] = DELTA_KEY;
+	} else {
+		for (y = 0; y < h;) {
+			if (memcmp(frame + y * rowbytes, prev + y * rowbytes, rowbytes) == 0) {
+				y++;
+				continue;
+			}
+			for (y0 = y++; y < h && memcmp(frame + y * rowbytes, prev + y * rowbytes, rowbytes) != 0; y++) {
+			}
+			o[n++] = y0;
+			o[n++] = y - y0;
+			n += rle(o + n, a + (size_t) y0 * w, b + (size_t) y0 * w, (size_t) (y - y0) * w);
+		}
+		o[0] = DELTA_ROWS;
+	}
+	o[1] = (n - 2) * 4;
+	return n * 4;
+}
+
+struct DeltaReader {
+	FILE *fp;
+	int width;
+	int height;
+	uint32_t *frame;				   // the frame decoded last
+	uint32_t *payload;
+	size_t payloadsize;
+	int started;					   // a keyframe has been read
+};
+
+// DeltaOpen opens a delta recording, returning the frame dimensions and CAPTURE_ flags
+DeltaReader *DeltaOpen(const char *filename, int *w, int *h, int *flags) {
+	uint32_t hdr[DELTA_HEADER / 4];
+	DeltaReader *d;
+	FILE *fp;
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL) {
+		return NULL;
+	}
+	// a frame, and the largest record of one, must fit in memory; on 32 bit machines the sizes could wrap
+	if (fread(hdr, sizeof(hdr), 1, fp) != 1 || memcmp(hdr, DELTA_MAGIC, 4) != 0 || hdr[1] != DELTA_VERSION
+	    || hdr[2] == 0 || hdr[3] == 0 || hdr[2] > 65536 || hdr[3] > 65536
+	    || (uint64_t) hdr[2] * hdr[3] * 4 + (uint64_t) hdr[3] * 12 + 16 > SIZE_MAX) {
+		fclose(fp);
+		return NULL;
+	}
+	d = (DeltaReader *) calloc(1, sizeof(DeltaReader));
+	if (d == NULL) {
+		fclose(fp);
+		return NULL;
+	}
+	d->fp = fp;
+	d->width = hdr[2];
+	d->height = hdr[3];
+	d->frame = (uint32_t *) malloc((size_t) d->width * d->height * 4);
+	if (d->frame == NULL) {
+		DeltaClose(d);
+		return NULL;
+	}
+	*w = d->width;
+	*h = d->height;
+	*flags = hdr[4];
+	return d;
+}
+
+// DeltaNext decodes the next frame, returning its pixels (width*4 bytes per row, valid until
+// the next call), or NULL at the end of the recording or if it is damaged
+const VGubyte *DeltaNext(DeltaReader * d) {
+	uint32_t rec[2], *p, *end;
+	size_t words, used, npix = (size_t) d->width * d->height;
+
+	if (fread(rec, sizeof(rec), 1, d->fp) != 1 || rec[1] % 4 != 0 || rec[1] > DeltaBound(d->width, d->height)) {
+		return NULL;
+	}
+	if (rec[1] > d->payloadsize) {
+		free(d->payload);
+		d->payload = (uint32_t *) malloc(rec[1]);
+		d->payloadsize = d->payload != NULL ? rec[1] : 0;
+		if (d->payload == NULL) {
+			return NULL;
+		}
+	}
+	if (rec[1] > 0 && fread(d->payload, rec[1], 1, d->fp) != 1) {
+		return NULL;
+	}
+	words = rec[1] / 4;
+	switch (rec[0]) {
+	case DELTA_KEY:
+		// unrle returns 0 when malformed, so an empty keyframe would pass
+		if (words == 0 || unrle(d->frame, d->payload, words, npix, 0) != words) {
+			return NULL;
+		}
+		d->started = 1;
+		break;
+	case DELTA_ROWS:
+		if (!d->started) {
+			return NULL;
+		}
+		for (p = d->payload, end = p + words; p < end; p += used) {
+			if (end - p < 2 || p[0] >= (uint32_t) d->height || p[1] == 0 || p[1] > d->height - p[0]) {
+				return NULL;
+			}
+			used = unrle(d->frame + (size_t) p[0] * d->width, p + 2, end - p - 2, (size_t) p[1] * d->width, 1);
+			if (used == 0) {
+				return NULL;
+			}
+			used += 2;
+		}
+		break;
+	default:
+		return NULL;
+	}
+	return (const VGubyte *)d->frame;
+}
+
+// DeltaClose closes a delta recording
+void DeltaClose(DeltaReader * d) {
+	if (d == NULL) {
+		return;
+	}
+	fclose(d->fp);
+	free(d->frame);
+	free(d->payload);
+	free(d);
+}
@@ -53,5 +53,8 @@ Colors are specfied with RGB triples (0-255) with alpha values (0.0-1.0), or nam
 Convenience functions are used to set the Background color, start the drawing with a background color, and save the raster to a file.
 The input terminal may be set/restored to/from raw and cooked mode.
 
+The drawing functions must be called from the goroutine that called Init. A Renderer owns that goroutine,
+and draws frames recorded in Batches by any goroutine.
+
 */
 package openvg
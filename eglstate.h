@@ -9,6 +9,15 @@ typedef struct {
 	uint32_t window_height;
 	// dispman window 
 	DISPMANX_ELEMENT_HANDLE_T element;
+	// dispman display, for snapshots
+	DISPMANX_DISPLAY_HANDLE_T dispman_display;
+
+	// surface options, from initSurface
+	int surface_flags;
+	int samples;
+	int swap_interval;
+	// the buffers are preserved on swap
+	int preserved;
 
 	// EGL data
 	EGLDisplay display;
@@ -20,3 +29,6 @@ typedef struct {
 extern void oglinit(STATE_T *);
 extern void dispmanMoveWindow(STATE_T *, int, int);
 extern void dispmanChangeWindowOpacity(STATE_T *, unsigned int);
+extern int frameswap(STATE_T *);
+extern int framevsync(STATE_T *, int);
+extern void framefinish();
@@ -0,0 +1,58 @@
+package openvg
+
+/*
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h" // font information
+#include "shapes.h"   // C API
+
+extern void goerror(char *, VGErrorCode, int);
+*/
+import "C"
+import "sync"
+
+// Error checking policies, for ErrorPolicy
+const (
+	ErrorsOff     = C.ERRORS_OFF     // never checked
+	ErrorsSampled = C.ERRORS_SAMPLED // at the end of every nth frame
+	ErrorsDebug   = C.ERRORS_DEBUG   // after every call
+)
+
+// ErrorHandler receives an error: the name of the call that failed (or of End, for a
+// sampled frame), the OpenVG error and the EGL error
+type ErrorHandler func(call string, vgerror, eglerror int)
+
+var (
+	errorlock    sync.Mutex
+	errorhandler ErrorHandler
+)
+
+//export goerror
+func goerror(call *C.char, vgerror C.VGErrorCode, eglerror C.int) {
+	errorlock.Lock()
+	h := errorhandler
+	errorlock.Unlock()
+	if h != nil {
+		h(C.GoString(call), int(vgerror), int(eglerror))
+	}
+}
+
+// ErrorPolicy sets when errors are checked: ErrorsOff never, ErrorsSampled at the end of
+// every nth frame, ErrorsDebug after every call. Checking waits for the GPU to catch up,
+// so the default is ErrorsSampled every 60 frames.
+func ErrorPolicy(mode, n int) {
+	C.ErrorPolicy(C.int(mode), C.int(n))
+}
+
+// ErrorCallback sets the function errors are reported to; nil restores the default,
+// which prints them on standard error. Errors do not stop the program.
+func ErrorCallback(h ErrorHandler) {
+	errorlock.Lock()
+	errorhandler = h
+	errorlock.Unlock()
+	if h == nil {
+		C.ErrorCallback(nil)
+		return
+	}
+	C.ErrorCallback(C.ErrorHandler(C.goerror))
+}
@@ -0,0 +1,241 @@
+//
+// frame: frame pacing and frame time statistics
+//
+// End swaps through frameswap, which times the frame, then paces the
+// loop: sleeping until the next tick of a target rate, or until the
+// next vertical sync, signalled by a dispmanx vsync callback. The last
+// FRAME_HISTORY frames' times are kept for FrameStatsRead, which may
+// be called from any thread.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "EGL/egl.h"
+#include "bcm_host.h"
+#include "eglstate.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+#define FRAME_JANK	1.5				   // periods, from one frame to the next, that make a jank
+#define FRAME_DEFAULTPERIOD	(1000.0 / 60)		   // ms, expected when not paced
+
+typedef struct {
+	VGfloat cpu, swap, interval;			   // ms
+} FrameTime;
+
+static pthread_mutex_t framelock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t vsynced = PTHREAD_COND_INITIALIZER;
+static FrameTime history[FRAME_HISTORY];		   // ring, of the last frames
+static int nhistory = 0, nexthistory = 0;
+static unsigned long frames = 0, janks = 0;
+static int64_t period = 0;				   // ns between paced frames, 0 for no pacing by time
+static int64_t deadline = 0;				   // next paced frame
+static int64_t lastswap = 0;				   // when the last frame was swapped
+static int64_t lastdone = 0;				   // when End last returned
+static int vsyncs = 0;					   // vertical syncs between frames, 0 for none
+static unsigned long vsynccount = 0;			   // counted by the callback
+static unsigned long lastvsync = 0;			   // the count at the last frame
+static int64_t vsyncperiod = 0;				   // measured ns between syncs
+static int64_t vsynctime = 0;
+static DISPMANX_DISPLAY_HANDLE_T vsyncdisplay = 0;	   // with the callback registered
+
+// now returns the monotonic time in ns
+static int64_t now() {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (int64_t) t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+// vsync counts vertical syncs, and wakes a frame waiting for one; it runs on a dispmanx thread
+static void vsync(DISPMANX_UPDATE_HANDLE_T u, void *arg) {
+	int64_t t = now();
+
+	pthread_mutex_lock(&framelock);
+	if (vsynctime != 0) {
+		vsyncperiod = vsyncperiod == 0 ? t - vsynctime : (vsyncperiod * 7 + (t - vsynctime)) / 8;
+	}
+	vsynctime = t;
+	vsynccount++;
+	pthread_cond_broadcast(&vsynced);
+	pthread_mutex_unlock(&framelock);
+}
+
+// expected returns the ms expected from frame to frame; framelock is held
+static VGfloat expected() {
+	if (vsyncs > 0 && vsyncperiod > 0) {
+		return vsyncs * vsyncperiod / 1e6;
+	}
+	if (period > 0) {
+		return period / 1e6;
+	}
+	return FRAME_DEFAULTPERIOD;
+}
+
+// frameswap shows the frame, times it, and waits for the next as paced.
+// Returns eglSwapBuffers' result.
+int frameswap(STATE_T * state) {
+	struct timespec t;
+	FrameTime ft;
+	EGLBoolean ok;
+	int64_t start, swapped, done;
+
+	start = now();
+	ok = eglSwapBuffers(state->display, state->surface);
+	swapped = now();
+
+	pthread_mutex_lock(&framelock);
+	ft.cpu = lastdone != 0 ? (start - lastdone) / 1e6 : -1;	// none for the first frame
+	ft.swap = (swapped - start) / 1e6;
+	ft.interval = lastswap != 0 ? (swapped - lastswap) / 1e6 : -1;
+	lastswap = swapped;
+	history[nexthistory] = ft;
+	nexthistory = (nexthistory + 1) % FRAME_HISTORY;
+	nhistory += nhistory < FRAME_HISTORY;
+	frames++;
+	if (ft.interval > FRAME_JANK * expected()) {
+		janks++;
+	}
+
+	if (vsyncs > 0) {
+		// on the vsyncs'th sync after the last frame, or the next, if that has passed
+		if (vsynccount - lastvsync >= (unsigned long)vsyncs) {
+			lastvsync = vsynccount;
+		}
+		// not for ever, should the syncs stop with the display
+		clock_gettime(CLOCK_REALTIME, &t);
+		t.tv_sec += 1;
+		while (vsyncdisplay != 0 && vsynccount - lastvsync < (unsigned long)vsyncs) {
+			if (pthread_cond_timedwait(&vsynced, &framelock, &t) == ETIMEDOUT) {
+				break;
+			}
+		}
+		lastvsync = vsynccount;
+		pthread_mutex_unlock(&framelock);
+	} else if (period > 0) {
+		deadline += period;
+		if (deadline < swapped) {
+			deadline = swapped;		   // late; start again from now, rather than hurry
+		}
+		t.tv_sec = deadline / 1000000000;
+		t.tv_nsec = deadline % 1000000000;
+		pthread_mutex_unlock(&framelock);
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR) {
+		}
+	} else {
+		pthread_mutex_unlock(&framelock);
+	}
+	done = now();
+	pthread_mutex_lock(&framelock);
+	lastdone = done;
+	pthread_mutex_unlock(&framelock);
+	return ok;
+}
+
+// setvsync registers the vsync callback, or removes it with display 0
+static int setvsync(DISPMANX_DISPLAY_HANDLE_T display) {
+	int err = 0;
+
+	if (vsyncdisplay != 0) {
+		vc_dispmanx_vsync_callback(vsyncdisplay, NULL, NULL);
+	}
+	pthread_mutex_lock(&framelock);
+	vsyncdisplay = 0;
+	vsyncperiod = vsynctime = 0;
+	pthread_cond_broadcast(&vsynced);
+	pthread_mutex_unlock(&framelock);
+	if (display != 0) {
+		err = vc_dispmanx_vsync_callback(display, vsync, NULL);
+		pthread_mutex_lock(&framelock);
+		vsyncdisplay = err == 0 ? display : 0;
+		lastvsync = vsynccount;
+		pthread_mutex_unlock(&framelock);
+	}
+	return err == 0 ? 0 : -1;
+}
+
+// framevsync paces End to every nth vertical sync of the state's display, or stops with n 0.
+// Returns 0, or -1 if the display has no vsync callback.
+int framevsync(STATE_T * state, int n) {
+	int err;
+
+	err = setvsync(n > 0 ? state->dispman_display : 0);
+	pthread_mutex_lock(&framelock);
+	vsyncs = err == 0 && n > 0 ? n : 0;
+	pthread_mutex_unlock(&framelock);
+	return err;
+}
+
+// framefinish stops pacing, before the display goes
+void framefinish() {
+	setvsync(0);
+	pthread_mutex_lock(&framelock);
+	vsyncs = 0;
+	period = 0;
+	pthread_mutex_unlock(&framelock);
+}
+
+// FrameRate paces End to fps frames a second, sleeping until it is time for the next frame,
+// instead of running as fast as drawing allows; 0 stops pacing. Frames that are late are not
+// hurried to catch up.
+void FrameRate(VGfloat fps) {
+	pthread_mutex_lock(&framelock);
+	period = fps > 0 ? (int64_t) (1e9 / fps) : 0;
+	deadline = now();
+	pthread_mutex_unlock(&framelock);
+}
+
+// FrameStatsReset starts the statistics again
+void FrameStatsReset() {
+	pthread_mutex_lock(&framelock);
+	nhistory = nexthistory = 0;
+	frames = janks = 0;
+	lastswap = lastdone = 0;
+	pthread_mutex_unlock(&framelock);
+}
+
+// frametimes adds a frame's time to the count, mean, maximum and histogram
+static void frametimes(FrameTimes * t, VGfloat ms) {
+	int b = (int)(ms / FRAME_BUCKETMS);
+
+	if (ms < 0) {
+		return;					   // not measured
+	}
+	t->count++;
+	t->mean += ms;
+	t->max = ms > t->max ? ms : t->max;
+	t->hist[b < 0 ? 0 : b >= FRAME_BUCKETS ? FRAME_BUCKETS - 1 : b]++;
+}
+
+// FrameStatsRead returns the frame statistics: counts since the start, and the times of
+// the last FRAME_HISTORY frames (up to) in ms: the CPU time between frames, the time in
+// eglSwapBuffers, and the interval from one frame to the next
+void FrameStatsRead(FrameStats * fs) {
+	FrameTime *ft;
+	int i, first;
+
+	memset(fs, 0, sizeof(*fs));
+	pthread_mutex_lock(&framelock);
+	fs->frames = frames;
+	fs->janks = janks;
+	fs->period = expected();
+	fs->count = nhistory;
+	first = (nexthistory - nhistory + FRAME_HISTORY) % FRAME_HISTORY;
+	for (i = 0; i < nhistory; i++) {
+		ft = &history[(first + i) % FRAME_HISTORY];
+		frametimes(&fs->cpu, ft->cpu);
+		frametimes(&fs->swap, ft->swap);
+		frametimes(&fs->interval, ft->interval);
+		fs->recentjanks += ft->interval > FRAME_JANK * fs->period;
+	}
+	pthread_mutex_unlock(&framelock);
+	fs->cpu.mean /= fs->cpu.count > 0 ? fs->cpu.count : 1;
+	fs->swap.mean /= fs->swap.count > 0 ? fs->swap.count : 1;
+	fs->interval.mean /= fs->interval.count > 0 ? fs->interval.count : 1;
+}
@@ -0,0 +1,117 @@
+// cgobench: compare drawing with a cgo call per primitive to drawing from a command batch,
+// and count the allocations made by text and polygon calls
+package main
+
+import (
+	"flag"
+	"fmt"
+	"math/rand"
+	"testing"
+
+	"github.com/ajstarks/openvg"
+)
+
+var width, height int
+
+// shape is a primitive to draw
+type shape struct {
+	x, y, size openvg.VGfloat
+	r, g, b    uint8
+}
+
+// percall draws the shapes with the package functions, a cgo call each
+func percall(shapes []shape) {
+	openvg.Start(width, height)
+	for _, s := range shapes {
+		openvg.FillRGB(s.r, s.g, s.b, 0.5)
+		openvg.Rect(s.x, s.y, s.size, s.size)
+		openvg.Circle(s.x, s.y, s.size)
+	}
+	openvg.End()
+}
+
+// batched records the shapes in a batch, drawn with one cgo call
+func batched(b *openvg.Batch, shapes []shape) {
+	openvg.Start(width, height)
+	for _, s := range shapes {
+		b.FillRGB(s.r, s.g, s.b, 0.5)
+		b.Rect(s.x, s.y, s.size, s.size)
+		b.Circle(s.x, s.y, s.size)
+	}
+	b.Flush()
+	openvg.End()
+}
+
+// text draws a label per shape
+func text(shapes []shape) {
+	openvg.Start(width, height)
+	openvg.FillRGB(0, 0, 0, 1)
+	for _, s := range shapes {
+		openvg.TextMid(s.x, s.y, "label", "sans", 12)
+	}
+	openvg.End()
+}
+
+// polygons draws a triangle per shape, from reused coordinate slices
+func polygons(shapes []shape) {
+	x := make([]openvg.VGfloat, 3)
+	y := make([]openvg.VGfloat, 3)
+	openvg.Start(width, height)
+	for _, s := range shapes {
+		x[0], x[1], x[2] = s.x, s.x+s.size, s.x+s.size/2
+		y[0], y[1], y[2] = s.y, s.y, s.y+s.size
+		openvg.FillRGB(s.r, s.g, s.b, 0.5)
+		openvg.Polygon(x, y)
+	}
+	openvg.End()
+}
+
+// report prints a benchmark result per frame and per call, for n calls a frame
+func report(name string, r testing.BenchmarkResult, n int) {
+	fmt.Printf("%-10s %10d ns/frame %8.1f ns/call %6d allocs/frame\n",
+		name, r.NsPerOp(), float64(r.NsPerOp())/float64(n), r.AllocsPerOp())
+}
+
+func main() {
+	var n = flag.Int("n", 1000, "shapes per frame")
+	flag.Parse()
+
+	width, height = openvg.Init()
+	shapes := make([]shape, *n)
+	for i := range shapes {
+		shapes[i] = shape{
+			x: openvg.VGfloat(rand.Intn(width)), y: openvg.VGfloat(rand.Intn(height)), size: openvg.VGfloat(rand.Intn(50) + 5),
+			r: uint8(rand.Intn(256)), g: uint8(rand.Intn(256)), b: uint8(rand.Intn(256)),
+		}
+	}
+	batch := openvg.NewBatch(*n * 16)
+	pc := testing.Benchmark(func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			percall(shapes)
+		}
+	})
+	bt := testing.Benchmark(func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			batched(batch, shapes)
+		}
+	})
+	tx := testing.Benchmark(func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			text(shapes)
+		}
+	})
+	pg := testing.Benchmark(func(b *testing.B) {
+		b.ReportAllocs()
+		for i := 0; i < b.N; i++ {
+			polygons(shapes)
+		}
+	})
+	openvg.Finish()
+	report("per call", pc, 3**n)
+	report("batched", bt, 3**n)
+	report("text", tx, *n)
+	report("polygon", pg, 2**n)
+}
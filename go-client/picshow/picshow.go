@@ -46,7 +46,7 @@ func main() {
 
 	flag.Parse()
 	w, h := openvg.Init()
-	images := []image.Image{}
+	images := []*openvg.ImageHandle{}
 	imgcount := 0
 	for _, imgfile := range flag.Args() {
 		fmt.Fprintf(os.Stderr, "loading %q ", imgfile)
@@ -55,18 +55,22 @@ func main() {
 			fmt.Fprintln(os.Stderr, err)
 			continue
 		}
-		images = append(images, img)
+		vgimg := openvg.NewImage(img) // convert and upload once
+		if vgimg == nil {
+			fmt.Fprintln(os.Stderr, "cannot make image")
+			continue
+		}
+		images = append(images, vgimg)
 		imgcount++
 		fmt.Fprintln(os.Stderr, "ok")
 	}
 	for {
 		for _, img := range images {
-			ib := img.Bounds()
-			imw, imh := ib.Max.X-ib.Min.X, ib.Max.Y-ib.Min.Y
+			imw, imh := img.Size()
 			openvg.Start(w, h)
 			openvg.BackgroundColor(*bgcolor)
 			x, y := openvg.VGfloat(w)/2-openvg.VGfloat(imw)/2, openvg.VGfloat(h)/2-openvg.VGfloat(imh)/2
-			openvg.Img(x, y, img)
+			img.Draw(x, y)
 			openvg.End()
 			time.Sleep(*delay)
 		}
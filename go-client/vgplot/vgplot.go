@@ -193,6 +193,16 @@ func plot(x, y, w, h openvg.VGfloat, settings plotset, d []rawdata) {
 		openvg.FillColor(settings.attr["bgcolor"])
 		openvg.Rect(x, y, w, h)
 	}
+	// Resolve the colors used for each data point once
+	barcolor := openvg.NewColor(settings.attr["barcolor"])
+	dotcolor := openvg.NewColor(settings.attr["dotcolor"])
+	black := openvg.NewColor("black")
+	silver := openvg.NewColor("silver")
+	defer barcolor.Destroy()
+	defer dotcolor.Destroy()
+	defer black.Destroy()
+	defer silver.Destroy()
+
 	// Loop through the data, drawing items as specified
 	spacer := openvg.VGfloat(10.0)
 	for i, v := range d {
@@ -203,20 +213,20 @@ func plot(x, y, w, h openvg.VGfloat, settings plotset, d []rawdata) {
 			ypoly[i+1] = yp
 		}
 		if settings.opt["showbar"] {
-			openvg.StrokeColor(settings.attr["barcolor"])
+			openvg.StrokeColorHandle(barcolor)
 			openvg.StrokeWidth(settings.size["barsize"])
 			openvg.Line(xp, yp, xp, y)
 		}
 		if settings.opt["showdot"] {
-			openvg.FillColor(settings.attr["dotcolor"])
+			openvg.FillColorHandle(dotcolor)
 			openvg.StrokeWidth(0)
 			openvg.Circle(xp, yp, settings.size["dotsize"])
 		}
 		if settings.opt["showx"] {
 			if i%int(settings.size["xinterval"]) == 0 {
-				openvg.FillColor("black")
+				openvg.FillColorHandle(black)
 				openvg.TextMid(xp, y-(spacer*2), fmt.Sprintf("%d", int(v.x)), settings.attr["font"], int(settings.size["fontsize"]))
-				openvg.StrokeColor("silver")
+				openvg.StrokeColorHandle(silver)
 				openvg.StrokeWidth(1)
 				openvg.Line(xp, y, xp, y-spacer)
 			}
@@ -242,9 +252,9 @@ func plot(x, y, w, h openvg.VGfloat, settings plotset, d []rawdata) {
 		interval := yrange / openvg.VGfloat(settings.size["yinterval"])
 		for yax := bot; yax <= top; yax += interval {
 			yaxp := fmap(yax, bot, top, openvg.VGfloat(y), openvg.VGfloat(y+h))
-			openvg.FillColor("black")
+			openvg.FillColorHandle(black)
 			openvg.TextEnd(x-spacer, yaxp, fmt.Sprintf("%.1f", yax), settings.attr["font"], int(settings.size["fontsize"]))
-			openvg.StrokeColor("silver")
+			openvg.StrokeColorHandle(silver)
 			openvg.StrokeWidth(1)
 			openvg.Line(x-spacer, yaxp, x, yaxp)
 		}
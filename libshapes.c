@@ -8,7 +8,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <termios.h>
-#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include <setjmp.h>
 #include <jpeglib.h>
 #include "VG/openvg.h"
 #include "VG/vgu.h"
@@ -19,6 +21,8 @@
 #include "DejaVuSansMono.inc"
 #include "eglstate.h"					   // data structures for graphics state
 #include "fontinfo.h"					   // font data structure
+#include "shapes.h"					   // public API
+#include "vgcheck.h"					   // error checking of the other modules
 
 static STATE_T _state, *state = &_state;	// global graphics state
 static const int MAXFONTPATH = 500;
@@ -26,6 +30,9 @@ static int init_x = 0;		// Initial window position and size
 static int init_y = 0;
 static unsigned int init_w = 0;
 static unsigned int init_h = 0;
+static int init_surface = 0;	// Initial surface options
+static int init_samples = 0;
+static int init_interval = 1;
 //
 // Terminal settings
 //
@@ -53,6 +60,82 @@ void restoreterm() {
 	tcsetattr(fileno(stdin), TCSANOW, &orig_term_attr);
 }
 
+//
+// Errors
+//
+
+static int errormode = ERRORS_SAMPLED;
+static int errorevery = ERRORS_SAMPLE;			   // frames from one check to the next, when sampled
+static unsigned long errorframe = 0;
+static ErrorHandler errorhandler = NULL;		   // NULL for errorlog
+
+// errorlog reports an error on standard error, the handler unless ErrorCallback sets another
+static void errorlog(const char *call, VGErrorCode vgerror, int eglerror) {
+	if (vgerror != VG_NO_ERROR) {
+		fprintf(stderr, "libshapes: %s: OpenVG error 0x%04x\n", call, vgerror);
+	}
+	if (eglerror != EGL_SUCCESS) {
+		fprintf(stderr, "libshapes: %s: EGL error 0x%04x\n", call, eglerror);
+	}
+}
+
+// reporterror passes an error to the handler
+static void reporterror(const char *call, VGErrorCode vgerror, int eglerror) {
+	(errorhandler != NULL ? errorhandler : errorlog) (call, vgerror, eglerror);
+}
+
+// vgcheck reports an OpenVG error from call, checked after every call with ERRORS_DEBUG,
+// here and in the other modules (see vgcheck.h). vgGetError waits for the GPU, so the
+// other policies do not call it here.
+void vgcheck(const char *call) {
+	VGErrorCode err;
+
+	if (errormode != ERRORS_DEBUG) {
+		return;
+	}
+	err = vgGetError();
+	if (err != VG_NO_ERROR) {
+		reporterror(call, err, EGL_SUCCESS);
+	}
+}
+
+// framecheck reports an OpenVG error from the frame, as the policy has it, before the swap
+static void framecheck(const char *call) {
+	VGErrorCode err;
+
+	errorframe++;
+	if (errormode == ERRORS_OFF || (errormode == ERRORS_SAMPLED && errorframe % errorevery != 0)) {
+		return;
+	}
+	err = vgGetError();
+	if (err != VG_NO_ERROR) {
+		reporterror(call, err, EGL_SUCCESS);
+	}
+}
+
+// swapcheck reports an EGL error from the swap. EGL errors are kept by the client library,
+// so reading one costs no round trip, and it is only read when the swap fails.
+static void swapcheck(int swapped) {
+	if (!swapped && errormode != ERRORS_OFF) {
+		reporterror("eglSwapBuffers", VG_NO_ERROR, eglGetError());
+	}
+}
+
+// ErrorPolicy sets when errors are checked: ERRORS_OFF never, ERRORS_SAMPLED at the end of
+// every nth frame, ERRORS_DEBUG after every call, naming the call. Checking waits for the GPU
+// to catch up, so the default is ERRORS_SAMPLED every ERRORS_SAMPLE frames.
+void ErrorPolicy(int mode, int n) {
+	errormode = mode;
+	errorevery = n > 0 ? n : 1;
+}
+
+// ErrorCallback sets the function errors are reported to, with the name of the call that
+// failed (or of End, for a sampled frame), the OpenVG error and the EGL error; NULL restores
+// the default, which prints them on standard error. Errors do not stop the program.
+void ErrorCallback(ErrorHandler h) {
+	errorhandler = h;
+}
+
 //
 // Font functions
 //
@@ -99,17 +182,16 @@ void unloadfont(VGPath * glyphs, int n) {
 	}
 }
 
-// createImageFromJpeg decompresses a JPEG image to the standard image format
+// readJpeg decompresses a JPEG whose header has been read to a raster of red, green, blue,
+// alpha values, bottom row first. The caller frees the returned data. If raster is not NULL,
+// the raster is stored there as soon as it is allocated, so a caller whose error handler
+// longjmps out of the decoding can free it.
 // source: https://github.com/ileben/ShivaVG/blob/master/examples/test_image.c
-VGImage createImageFromJpeg(const char *filename) {
-	FILE *infile;
-	struct jpeg_decompress_struct jdc;
-	struct jpeg_error_mgr jerr;
+static VGubyte *readJpeg(struct jpeg_decompress_struct *jdc, int *w, int *h, VGubyte * volatile *raster) {
 	JSAMPARRAY buffer;
 	unsigned int bstride;
 	unsigned int bbpp;
 
-	VGImage img;
 	VGubyte *data;
 	unsigned int width;
 	unsigned int height;
@@ -118,21 +200,73 @@ VGImage createImageFromJpeg(const char *filename) {
 
 	VGubyte *brow;
 	VGubyte *drow;
-	unsigned int x;
-	unsigned int lilEndianTest = 1;
-	VGImageFormat rgbaFormat;
 
-	// Check for endianness
-	if (((unsigned char *)&lilEndianTest)[0] == 1)
-		rgbaFormat = VG_sABGR_8888;
-	else
-		rgbaFormat = VG_sRGBA_8888;
+#ifdef JCS_EXTENSIONS
+	// libjpeg-turbo can decode color straight to RGBA
+	if (jdc->jpeg_color_space == JCS_YCbCr || jdc->jpeg_color_space == JCS_RGB) {
+		jdc->out_color_space = JCS_EXT_RGBA;
+	}
+#endif
+	jpeg_start_decompress(jdc);
+	width = jdc->output_width;
+	height = jdc->output_height;
+
+	// Allocate buffer using jpeg allocator
+	bbpp = jdc->output_components;
+	bstride = width * bbpp;
+	buffer = (*jdc->mem->alloc_sarray)
+	    ((j_common_ptr) jdc, JPOOL_IMAGE, bstride, 1);
+
+	// Allocate image data buffer
+	dbpp = 4;
+	dstride = width * dbpp;
+	data = (VGubyte *) malloc(dstride * height);
+	if (data == NULL) {
+		jpeg_abort_decompress(jdc);
+		return NULL;
+	}
+	if (raster != NULL) {
+		*raster = data;
+	}
+	// Iterate until all scanlines processed
+	while (jdc->output_scanline < height) {
+		drow = data + (height - 1 - jdc->output_scanline) * dstride;
+		if (bbpp == 4) {			   // already four bytes per pixel
+			jpeg_read_scanlines(jdc, &drow, 1);
+			continue;
+		}
+		// Read scanline into buffer and expand to RGBA
+		jpeg_read_scanlines(jdc, buffer, 1);
+		brow = buffer[0];
+		switch (bbpp) {
+		case 3:
+			RGBtoRGBA(drow, brow, width);
+			break;
+		case 1:
+			GraytoRGBA(drow, brow, width);
+			break;
+		}
+	}
+	jpeg_finish_decompress(jdc);
+
+	*w = width;
+	*h = height;
+	return data;
+}
+
+// decodeJpeg decompresses a JPEG file to a raster of red, green, blue, alpha values,
+// bottom row first. The caller frees the returned data.
+VGubyte *decodeJpeg(const char *filename, int *w, int *h) {
+	FILE *infile;
+	struct jpeg_decompress_struct jdc;
+	struct jpeg_error_mgr jerr;
+	VGubyte *data;
 
 	// Try to open image file
 	infile = fopen(filename, "rb");
 	if (infile == NULL) {
 		printf("Failed opening '%s' for reading!\n", filename);
-		return VG_INVALID_HANDLE;
+		return NULL;
 	}
 	// Setup default error handling
 	jdc.err = jpeg_std_error(&jerr);
@@ -141,69 +275,464 @@ VGImage createImageFromJpeg(const char *filename) {
 	// Set input file
 	jpeg_stdio_src(&jdc, infile);
 
-	// Read header and start
+	// Read header and decompress
 	jpeg_read_header(&jdc, TRUE);
-	jpeg_start_decompress(&jdc);
-	width = jdc.output_width;
-	height = jdc.output_height;
+	data = readJpeg(&jdc, w, h, NULL);
 
-	// Allocate buffer using jpeg allocator
-	bbpp = jdc.output_components;
-	bstride = width * bbpp;
-	buffer = (*jdc.mem->alloc_sarray)
-	    ((j_common_ptr) & jdc, JPOOL_IMAGE, bstride, 1);
+	// Cleanup
+	jpeg_destroy_decompress(&jdc);
+	fclose(infile);
+	return data;
+}
 
-	// Allocate image data buffer
-	dbpp = 4;
-	dstride = width * dbpp;
-	data = (VGubyte *) malloc(dstride * height);
+//
+// Thumbnails
+//
 
-	// Iterate until all scanlines processed
-	while (jdc.output_scanline < height) {
+// exif16 and exif32 read TIFF integers in the byte order of the EXIF block
+static unsigned int exif16(const JOCTET * p, int motorola) {
+	return motorola ? (p[0] << 8) | p[1] : (p[1] << 8) | p[0];
+}
 
-		// Read scanline into buffer
-		jpeg_read_scanlines(&jdc, buffer, 1);
-		drow = data + (height - jdc.output_scanline) * dstride;
-		brow = buffer[0];
-		// Expand to RGBA
-		for (x = 0; x < width; ++x, drow += dbpp, brow += bbpp) {
-			switch (bbpp) {
-			case 4:
-				drow[0] = brow[0];
-				drow[1] = brow[1];
-				drow[2] = brow[2];
-				drow[3] = brow[3];
-				break;
-			case 3:
-				drow[0] = brow[0];
-				drow[1] = brow[1];
-				drow[2] = brow[2];
-				drow[3] = 255;
-				break;
-			}
+static unsigned int exif32(const JOCTET * p, int motorola) {
+	return motorola ? (exif16(p, 1) << 16) | exif16(p + 2, 1) : (exif16(p + 2, 0) << 16) | exif16(p, 0);
+}
+
+// exifThumbnail finds the JPEG thumbnail in an EXIF APP1 marker: the offset and length
+// given by tags 0x0201 and 0x0202 of the second IFD, which describes the thumbnail.
+static const JOCTET *exifThumbnail(jpeg_saved_marker_ptr m, unsigned int *len) {
+	const JOCTET *tiff;
+	unsigned int size, ifd, n, i, tag, off = 0, length = 0;
+	int motorola;
+
+	if (m->data_length < 14 || memcmp(m->data, "Exif\0\0", 6) != 0) {
+		return NULL;
+	}
+	tiff = m->data + 6;
+	size = m->data_length - 6;
+	if (memcmp(tiff, "MM", 2) == 0) {
+		motorola = 1;
+	} else if (memcmp(tiff, "II", 2) == 0) {
+		motorola = 0;
+	} else {
+		return NULL;
+	}
+	// skip IFD0 to reach IFD1
+	ifd = exif32(tiff + 4, motorola);
+	if (ifd > size - 2) {
+		return NULL;
+	}
+	n = exif16(tiff + ifd, motorola);
+	ifd += 2 + n * 12;
+	if (ifd > size - 4) {
+		return NULL;
+	}
+	ifd = exif32(tiff + ifd, motorola);
+	if (ifd == 0 || ifd > size - 2) {
+		return NULL;
+	}
+	n = exif16(tiff + ifd, motorola);
+	for (i = 0; i < n && ifd + 2 + (i + 1) * 12 <= size; i++) {
+		const JOCTET *e = tiff + ifd + 2 + i * 12;
+		tag = exif16(e, motorola);
+		if (tag == 0x0201) {
+			off = exif32(e + 8, motorola);
+		} else if (tag == 0x0202) {
+			length = exif32(e + 8, motorola);
 		}
 	}
+	if (off == 0 || length == 0 || off > size || length > size - off) {
+		return NULL;
+	}
+	*len = length;
+	return tiff + off;
+}
 
-	// Create VG image
-	img = vgCreateImage(rgbaFormat, width, height, VG_IMAGE_QUALITY_BETTER);
-	vgImageSubData(img, data, dstride, rgbaFormat, 0, 0, width, height);
+#if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
+// thumberror is the error manager for embedded thumbnails, which are sometimes damaged;
+// errors return to the caller instead of exiting.
+typedef struct {
+	struct jpeg_error_mgr mgr;
+	jmp_buf env;
+} thumberror;
 
-	// Cleanup
+static void thumbexit(j_common_ptr cinfo) {
+	longjmp(((thumberror *) cinfo->err)->env, 1);
+}
+
+// decodeThumbnail decompresses an embedded thumbnail of at least w x h pixels
+static VGubyte *decodeThumbnail(const JOCTET * p, unsigned int len, int w, int h, int *tw, int *th) {
+	struct jpeg_decompress_struct jdc;
+	thumberror jerr;
+	VGubyte *data = NULL;
+	VGubyte *volatile raster = NULL;		   // kept across the longjmp, to be freed
+
+	jdc.err = jpeg_std_error(&jerr.mgr);
+	jerr.mgr.error_exit = thumbexit;
+	if (setjmp(jerr.env)) {
+		jpeg_destroy_decompress(&jdc);
+		free(raster);
+		return NULL;
+	}
+	jpeg_create_decompress(&jdc);
+	jpeg_mem_src(&jdc, (unsigned char *)p, len);
+	jpeg_read_header(&jdc, TRUE);
+	if ((int)jdc.image_width >= w && (int)jdc.image_height >= h) {
+		data = readJpeg(&jdc, tw, th, &raster);
+	}
+	jpeg_destroy_decompress(&jdc);
+	return data;
+}
+#endif
+
+// decodeJpegThumbnail decompresses a JPEG file to a raster of red, green, blue, alpha values
+// of at least w x h pixels, where the picture is that large, and as small as it can cheaply be.
+// The thumbnail a camera embeds in the EXIF data is used when it is big enough, otherwise the
+// picture is decoded scaled down by 1/2, 1/4 or 1/8. The dimensions are returned in tw, th.
+VGubyte *decodeJpegThumbnail(const char *filename, int w, int h, int *tw, int *th) {
+	FILE *infile;
+	struct jpeg_decompress_struct jdc;
+	struct jpeg_error_mgr jerr;
+	jpeg_saved_marker_ptr m;
+	const JOCTET *thumb;
+	unsigned int len;
+	VGubyte *data = NULL;
+	int denom;
+
+	infile = fopen(filename, "rb");
+	if (infile == NULL) {
+		printf("Failed opening '%s' for reading!\n", filename);
+		return NULL;
+	}
+	jdc.err = jpeg_std_error(&jerr);
+	jpeg_create_decompress(&jdc);
+	jpeg_stdio_src(&jdc, infile);
+	jpeg_save_markers(&jdc, JPEG_APP0 + 1, 0xffff);
+	jpeg_read_header(&jdc, TRUE);
+
+#if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
+	for (m = jdc.marker_list; m != NULL && data == NULL; m = m->next) {
+		if (m->marker == JPEG_APP0 + 1 && (thumb = exifThumbnail(m, &len)) != NULL) {
+			data = decodeThumbnail(thumb, len, w, h, tw, th);
+		}
+	}
+#endif
+	if (data == NULL) {
+		// the smallest power of two reduction that is still at least w x h
+		for (denom = 8; denom > 1; denom /= 2) {
+			if ((int)jdc.image_width / denom >= w && (int)jdc.image_height / denom >= h) {
+				break;
+			}
+		}
+		jdc.scale_num = 1;
+		jdc.scale_denom = denom;
+		data = readJpeg(&jdc, tw, th, NULL);
+	}
 	jpeg_destroy_decompress(&jdc);
 	fclose(infile);
+	return data;
+}
+
+// createThumbnailFromJpeg makes an image of at least w x h pixels from a JPEG file,
+// as for decodeJpegThumbnail
+VGImage createThumbnailFromJpeg(const char *filename, int w, int h) {
+	VGImage img;
+	VGubyte *data;
+	int tw, th;
+
+	data = decodeJpegThumbnail(filename, w, h, &tw, &th);
+	if (data == NULL) {
+		return VG_INVALID_HANDLE;
+	}
+	img = createImage(data, tw, th, tw * 4, ALPHA_PREMULTIPLIED);
 	free(data);
+	return img;
+}
+
+// Thumbnail draws a JPEG file at (x,y) scaled to (w,h), decoding as little of it as it can
+void Thumbnail(VGfloat x, VGfloat y, int w, int h, const char *filename) {
+	VGImage img = createThumbnailFromJpeg(filename, w, h);
+	if (img != VG_INVALID_HANDLE) {
+		DrawImageScaled(img, x, y, w, h);
+		vgDestroyImage(img);
+	}
+	vgcheck("Thumbnail");
+}
+
+// rgbaformat returns the VG format whose memory layout is red, green, blue, alpha bytes
+VGImageFormat rgbaformat() {
+	unsigned int lilEndianTest = 1;
+
+	// Check for endianness
+	if (((unsigned char *)&lilEndianTest)[0] == 1)
+		return VG_sABGR_8888;
+	else
+		return VG_sRGBA_8888;
+}
+
+// alphaformat returns the format for red, green, blue, alpha bytes in an alpha mode;
+// ALPHA_PREMULTIPLY and ALPHA_PREMULTIPLIED images use the premultiplied (_PRE) format,
+// so blending them does not convert every pixel, every frame.
+VGImageFormat alphaformat(int alphamode) {
+	VGImageFormat f = rgbaformat();
+	if (alphamode == ALPHA_STRAIGHT) {
+		return f;
+	}
+	return f == VG_sABGR_8888 ? VG_sABGR_8888_PRE : VG_sRGBA_8888_PRE;
+}
 
+// createImage makes an image from a raster of red, green, blue, alpha values
+// (bottom row first, stride bytes per row); with ALPHA_PREMULTIPLY the colors
+// are multiplied by alpha here, once.
+VGImage createImage(const VGubyte * data, int w, int h, int stride, int alphamode) {
+	VGImageFormat format = alphaformat(alphamode);
+	VGImage img;
+	VGubyte *pre;
+	int y;
+
+	img = vgCreateImage(format, w, h, VG_IMAGE_QUALITY_BETTER);
+	if (img == VG_INVALID_HANDLE) {
+		return img;
+	}
+	if (alphamode != ALPHA_PREMULTIPLY) {
+		vgImageSubData(img, data, stride, format, 0, 0, w, h);
+		vgcheck("createImage");
+		return img;
+	}
+	pre = (VGubyte *) malloc(w * h * 4);
+	if (pre == NULL) {
+		vgDestroyImage(img);
+		return VG_INVALID_HANDLE;
+	}
+	for (y = 0; y < h; y++) {
+		PremultiplyRGBA(pre + y * w * 4, data + y * stride, w);
+	}
+	vgImageSubData(img, pre, w * 4, format, 0, 0, w, h);
+	free(pre);
+	vgcheck("createImage");
 	return img;
 }
 
+// createImageFromJpeg decompresses a JPEG image to the standard image format;
+// JPEG pixels are opaque, so they are uploaded as premultiplied.
+VGImage createImageFromJpeg(const char *filename) {
+	VGImage img;
+	VGubyte *data;
+	int width, height;
+
+	data = decodeJpeg(filename, &width, &height);
+	if (data == NULL) {
+		return VG_INVALID_HANDLE;
+	}
+	img = createImage(data, width, height, width * 4, ALPHA_PREMULTIPLIED);
+	free(data);
+
+	return img;
+}
+
+//
+// Streaming images
+//
+
+struct StreamImage {
+	VGImage image[2];
+	int buffers;					   // 1, or 2 to upload while the other image is drawn
+	int front;					   // image shown by StreamImageDraw
+	int width;
+	int height;
+	VGImageFormat format;
+	int alpha;					   // alpha mode of updates
+	VGint stale[4];					   // region of the back image older than the front
+	VGubyte *buffer;				   // upload buffer for converted frames
+};
+
+// StreamImageCreateAlpha allocates a persistent w x h image for rasters that are updated
+// every frame; with two buffers, updates go to the image not being drawn.
+// alphamode is as for createImage.
+StreamImage *StreamImageCreateAlpha(int w, int h, int buffers, int alphamode) {
+	StreamImage *si;
+	int i;
+
+	si = (StreamImage *) calloc(1, sizeof(StreamImage));
+	if (si == NULL) {
+		return NULL;
+	}
+	si->buffers = buffers == 2 ? 2 : 1;
+	si->width = w;
+	si->height = h;
+	si->format = alphaformat(alphamode);
+	si->alpha = alphamode;
+	for (i = 0; i < si->buffers; i++) {
+		si->image[i] = vgCreateImage(si->format, w, h, VG_IMAGE_QUALITY_BETTER);
+		if (si->image[i] == VG_INVALID_HANDLE) {
+			StreamImageDestroy(si);
+			return NULL;
+		}
+	}
+	return si;
+}
+
+// StreamImageCreate allocates a streaming image for rasters that are not premultiplied
+StreamImage *StreamImageCreate(int w, int h, int buffers) {
+	return StreamImageCreateAlpha(w, h, buffers, ALPHA_STRAIGHT);
+}
+
+// streambuffer returns the stream's upload buffer, allocating it on first use
+static VGubyte *streambuffer(StreamImage * si) {
+	void *p;
+	if (si->buffer == NULL && posix_memalign(&p, 16, si->width * si->height * 4) == 0) {
+		si->buffer = (VGubyte *) p;
+	}
+	return si->buffer;
+}
+
+// streamupload copies the (x,y,w,h) region of a raster the size of the stream image to the image
+static void streamupload(StreamImage * si, const VGubyte * data, int stride, int x, int y, int w, int h) {
+	VGImage back;
+	VGint *st = si->stale;
+
+	if (x < 0) {
+		w += x;
+		x = 0;
+	}
+	if (y < 0) {
+		h += y;
+		y = 0;
+	}
+	if (x + w > si->width) {
+		w = si->width - x;
+	}
+	if (y + h > si->height) {
+		h = si->height - y;
+	}
+	if (w <= 0 || h <= 0) {
+		return;
+	}
+	if (si->buffers == 1) {
+		vgImageSubData(si->image[0], data + y * stride + x * 4, stride, si->format, x, y, w, h);
+		return;
+	}
+	// bring the back image up to date with the last update, unless this one covers it
+	back = si->image[si->front ^ 1];
+	if (st[2] > 0 && !(x <= st[0] && y <= st[1] && x + w >= st[0] + st[2] && y + h >= st[1] + st[3])) {
+		vgCopyImage(back, st[0], st[1], si->image[si->front], st[0], st[1], st[2], st[3], VG_FALSE);
+	}
+	vgImageSubData(back, data + y * stride + x * 4, stride, si->format, x, y, w, h);
+	st[0] = x;
+	st[1] = y;
+	st[2] = w;
+	st[3] = h;
+	si->front ^= 1;
+}
+
+// StreamImageUpdateRect copies the (x,y,w,h) region of a raster of red, green, blue, alpha
+// values (bottom row first, stride bytes per row, the size of the stream image) to the image.
+void StreamImageUpdateRect(StreamImage * si, const VGubyte * data, int stride, int x, int y, int w, int h) {
+	VGubyte *buf;
+	int row;
+
+	if (si->alpha == ALPHA_PREMULTIPLY) {
+		buf = streambuffer(si);
+		if (buf == NULL) {
+			return;
+		}
+		if (x < 0) {
+			w += x;
+			x = 0;
+		}
+		if (y < 0) {
+			h += y;
+			y = 0;
+		}
+		if (x + w > si->width) {
+			w = si->width - x;
+		}
+		for (row = y; row < y + h && row < si->height; row++) {
+			PremultiplyRGBA(buf + row * si->width * 4 + x * 4, data + row * stride + x * 4, w);
+		}
+		data = buf;
+		stride = si->width * 4;
+	}
+	streamupload(si, data, stride, x, y, w, h);
+	vgcheck("StreamImageUpdateRect");
+}
+
+// StreamImageUpdate copies a whole raster to the image
+void StreamImageUpdate(StreamImage * si, const VGubyte * data, int stride) {
+	StreamImageUpdateRect(si, data, stride, 0, 0, si->width, si->height);
+}
+
+// StreamImageUpdateI420 converts a planar 4:2:0 video frame the size of the image, and uploads it
+void StreamImageUpdateI420(StreamImage * si, const VGubyte * y, const VGubyte * u, const VGubyte * v, int ystride, int uvstride,
+			   int range) {
+	VGubyte *buf = streambuffer(si);
+	if (buf == NULL) {
+		return;
+	}
+	I420toRGBA(buf, si->width * 4, y, u, v, ystride, uvstride, si->width, si->height, range);
+	streamupload(si, buf, si->width * 4, 0, 0, si->width, si->height);
+	vgcheck("StreamImageUpdateI420");
+}
+
+// StreamImageUpdateNV12 converts a semi-planar 4:2:0 video frame the size of the image, and uploads it
+void StreamImageUpdateNV12(StreamImage * si, const VGubyte * y, const VGubyte * uv, int ystride, int uvstride, int range) {
+	VGubyte *buf = streambuffer(si);
+	if (buf == NULL) {
+		return;
+	}
+	NV12toRGBA(buf, si->width * 4, y, uv, ystride, uvstride, si->width, si->height, range);
+	streamupload(si, buf, si->width * 4, 0, 0, si->width, si->height);
+	vgcheck("StreamImageUpdateNV12");
+}
+
+// StreamImageHandle returns the most recently updated image
+VGImage StreamImageHandle(StreamImage * si) {
+	return si->image[si->front];
+}
+
+// StreamImageDraw places the most recently updated image at (x,y)
+void StreamImageDraw(StreamImage * si, VGfloat x, VGfloat y) {
+	vgSetPixels(x, y, si->image[si->front], 0, 0, si->width, si->height);
+	vgcheck("StreamImageDraw");
+}
+
+// StreamImageDestroy frees the image
+void StreamImageDestroy(StreamImage * si) {
+	int i;
+
+	if (si == NULL) {
+		return;
+	}
+	for (i = 0; i < si->buffers; i++) {
+		if (si->image[i] != VG_INVALID_HANDLE) {
+			vgDestroyImage(si->image[i]);
+		}
+	}
+	free(si->buffer);
+	free(si);
+}
+
+// makeimagestream is reused by makeimage while the raster size and alpha mode stay the same
+static StreamImage *makeimagestream = NULL;
+
+// makeimageAlpha makes an image from a raw raster of red, green, blue, alpha values
+// in the given alpha mode
+void makeimageAlpha(VGfloat x, VGfloat y, int w, int h, VGubyte * data, int alphamode) {
+	StreamImage *si = makeimagestream;
+	if (si == NULL || si->width != w || si->height != h || si->alpha != alphamode) {
+		StreamImageDestroy(si);
+		si = makeimagestream = StreamImageCreateAlpha(w, h, 1, alphamode);
+		if (si == NULL) {
+			return;
+		}
+	}
+	StreamImageUpdate(si, data, w * 4);
+	StreamImageDraw(si, x, y);
+}
+
 // makeimage makes an image from a raw raster of red, green, blue, alpha values
 void makeimage(VGfloat x, VGfloat y, int w, int h, VGubyte * data) {
-	unsigned int dstride = w * 4;
-	VGImageFormat rgbaFormat = VG_sABGR_8888;
-	VGImage img = vgCreateImage(rgbaFormat, w, h, VG_IMAGE_QUALITY_BETTER);
-	vgImageSubData(img, (void *)data, dstride, rgbaFormat, 0, 0, w, h);
-	vgSetPixels(x, y, img, 0, 0, w, h);
-	vgDestroyImage(img);
+	makeimageAlpha(x, y, w, h, data, ALPHA_STRAIGHT);
 }
 
 // Image places an image at the specifed location
@@ -211,14 +740,126 @@ void Image(VGfloat x, VGfloat y, int w, int h, const char *filename) {
 	VGImage img = createImageFromJpeg(filename);
 	vgSetPixels(x, y, img, 0, 0, w, h);
 	vgDestroyImage(img);
+	vgcheck("Image");
+}
+
+//
+// Screen capture
+//
+
+static VGubyte *capturebuf = NULL;			   // kept between captures, grown as needed
+static size_t capturesize = 0;
+static DISPMANX_RESOURCE_HANDLE_T snapshot = 0;	   // screen sized, kept between display captures
+static VGubyte *snapshotbuf = NULL;			   // rows read from the snapshot
+static int snapshotpitch = 0;
+
+// snapshotinto reads the w x h rectangle at (x,y) of the window as CaptureRectInto, but as
+// composited on the display, with the layers above and below, from a dispmanx snapshot
+static int snapshotinto(VGubyte * dst, int stride, int x, int y, int w, int h, int flags) {
+	VC_RECT_T rect;
+	uint32_t image;
+	int sx, sy, i;
+
+	sx = state->window_x + x;
+	sy = state->window_y + (int)state->window_height - (y + h);	// screen rows are top down
+	if (sx < 0 || sy < 0 || sx + w > (int)state->screen_width || sy + h > (int)state->screen_height) {
+		return -1;				   // off screen
+	}
+	if (snapshot == 0) {
+		snapshotpitch = ((state->screen_width + 15) & ~15) * 4;	// as dispmanx lays out RGBA32
+		snapshotbuf = (VGubyte *) malloc((size_t) snapshotpitch * state->screen_height);
+		if (snapshotbuf == NULL) {
+			return -1;
+		}
+		snapshot = vc_dispmanx_resource_create(VC_IMAGE_RGBA32, state->screen_width, state->screen_height, &image);
+		if (snapshot == 0) {
+			free(snapshotbuf);
+			snapshotbuf = NULL;
+			return -1;
+		}
+	}
+	if (vc_dispmanx_snapshot(state->dispman_display, snapshot, DISPMANX_NO_ROTATE) != 0) {
+		return -1;
+	}
+	// whole rows are read, placed pitch * row into the buffer
+	vc_dispmanx_rect_set(&rect, 0, sy, state->screen_width, h);
+	if (vc_dispmanx_resource_read_data(snapshot, &rect, snapshotbuf, snapshotpitch) != 0) {
+		return -1;
+	}
+	for (i = 0; i < h; i++) {
+		memcpy(dst + (size_t) (flags & CAPTURE_TOPDOWN ? i : h - 1 - i) * stride,
+		       snapshotbuf + (size_t) (sy + i) * snapshotpitch + sx * 4, (size_t) w * 4);
+	}
+	return 0;
 }
 
-// dumpscreen writes the raster
+// CaptureRectInto reads the w x h rectangle at (x,y) of the window into dst, stride bytes per row,
+// as red, green, blue, alpha bytes; bottom row first, or top row first with CAPTURE_TOPDOWN.
+// With CAPTURE_DISPLAY, the rectangle is read as shown on the display, with other dispmanx layers
+// (video, say), without stalling OpenVG; it is the frame last shown, so capture after End.
+// Returns 0, or -1 if the rectangle is not within the window (or the screen).
+int CaptureRectInto(VGubyte * dst, int stride, int x, int y, int w, int h, int flags) {
+	if (w <= 0 || h <= 0 || x < 0 || y < 0 || x + w > (int)state->window_width || y + h > (int)state->window_height) {
+		return -1;
+	}
+	if (flags & CAPTURE_DISPLAY) {
+		return snapshotinto(dst, stride, x, y, w, h, flags);
+	}
+	vgReadPixels(dst, stride, VG_sABGR_8888, x, y, w, h);
+	if (flags & CAPTURE_TOPDOWN) {
+		FlipRaster(dst, stride, dst, stride, w * 4, h);
+	}
+	return 0;
+}
+
+// CaptureRect reads a rectangle of the window as CaptureRectInto, into rows of w*4 bytes
+// in a buffer kept between captures. The pixels are valid until the next capture.
+const VGubyte *CaptureRect(int x, int y, int w, int h, int flags) {
+	size_t n = (size_t) w * h * 4;
+
+	if (w <= 0 || h <= 0) {
+		return NULL;
+	}
+	if (n > capturesize) {
+		free(capturebuf);			   // the old pixels are not needed, so no realloc
+		capturebuf = (VGubyte *) malloc(n);
+		capturesize = capturebuf != NULL ? n : 0;
+		if (capturebuf == NULL) {
+			return NULL;
+		}
+	}
+	if (CaptureRectInto(capturebuf, w * 4, x, y, w, h, flags) != 0) {
+		return NULL;
+	}
+	return capturebuf;
+}
+
+// CaptureWindow reads the whole window as CaptureRect, returning its dimensions
+const VGubyte *CaptureWindow(int flags, int *w, int *h) {
+	*w = state->window_width;
+	*h = state->window_height;
+	return CaptureRect(0, 0, *w, *h, flags);
+}
+
+// CaptureFree frees the capture buffer, and the display snapshot
+void CaptureFree() {
+	free(capturebuf);
+	capturebuf = NULL;
+	capturesize = 0;
+	if (snapshot != 0) {
+		vc_dispmanx_resource_delete(snapshot);
+		snapshot = 0;
+	}
+	free(snapshotbuf);
+	snapshotbuf = NULL;
+}
+
+// dumpscreen writes the w x h raster at the lower left of the window
 void dumpscreen(int w, int h, FILE * fp) {
-	void *ScreenBuffer = malloc(w * h * 4);
-	vgReadPixels(ScreenBuffer, (w * 4), VG_sABGR_8888, 0, 0, w, h);
-	fwrite(ScreenBuffer, 1, w * h * 4, fp);
-	free(ScreenBuffer);
+	const VGubyte *pixels = CaptureRect(0, 0, w, h, 0);
+	if (pixels != NULL) {
+		fwrite(pixels, 1, (size_t) w * h * 4, fp);
+	}
 }
 
 Fontinfo SansTypeface, SerifTypeface, MonoTypeface;
@@ -233,6 +874,15 @@ void initWindowSize(int x, int y, unsigned int w, unsigned int h) {
 	init_h = h;
 }
 
+// initSurface sets the window surface's format and swap behavior, before init: flags are SURFACE_ flags,
+// samples the multisamples a pixel (0 for none, and none if the display has no such config), and interval
+// the vertical syncs from one swap to the next (1, the default; 0 swaps without waiting for one)
+void initSurface(int flags, int samples, int interval) {
+	init_surface = flags;
+	init_samples = samples;
+	init_interval = interval < 0 ? 0 : interval;
+}
+
 // init sets the system to its initial state
 void init(int *w, int *h) {
 	bcm_host_init();
@@ -241,6 +891,9 @@ void init(int *w, int *h) {
 	state->window_y = init_y;
 	state->window_width = init_w;
 	state->window_height = init_h;
+	state->surface_flags = init_surface;
+	state->samples = init_samples;
+	state->swap_interval = init_interval;
 	oglinit(state);
 	SansTypeface = loadfont(DejaVuSans_glyphPoints,
 				DejaVuSans_glyphPointIndices,
@@ -275,6 +928,10 @@ void init(int *w, int *h) {
 
 // finish cleans up
 void finish() {
+	StreamImageDestroy(makeimagestream);
+	makeimagestream = NULL;
+	CaptureFree();
+	framefinish();
 	unloadfont(SansTypeface.Glyphs, SansTypeface.Count);
 	unloadfont(SerifTypeface.Glyphs, SerifTypeface.Count);
 	unloadfont(MonoTypeface.Glyphs, MonoTypeface.Count);
@@ -292,21 +949,25 @@ void finish() {
 // Translate the coordinate system to x,y
 void Translate(VGfloat x, VGfloat y) {
 	vgTranslate(x, y);
+	vgcheck("Translate");
 }
 
 // Rotate around angle r
 void Rotate(VGfloat r) {
 	vgRotate(r);
+	vgcheck("Rotate");
 }
 
 // Shear shears the x coordinate by x degrees, the y coordinate by y degrees
 void Shear(VGfloat x, VGfloat y) {
 	vgShear(x, y);
+	vgcheck("Shear");
 }
 
 // Scale scales by  x, y
 void Scale(VGfloat x, VGfloat y) {
 	vgScale(x, y);
+	vgcheck("Scale");
 }
 
 //
@@ -336,6 +997,7 @@ void StrokeWidth(VGfloat width) {
 	vgSetf(VG_STROKE_LINE_WIDTH, width);
 	vgSeti(VG_STROKE_CAP_STYLE, VG_CAP_BUTT);
 	vgSeti(VG_STROKE_JOIN_STYLE, VG_JOIN_MITER);
+	vgcheck("StrokeWidth");
 }
 
 //
@@ -373,6 +1035,7 @@ void Stroke(unsigned int r, unsigned int g, unsigned int b, VGfloat a) {
 	VGfloat color[4];
 	RGBA(r, g, b, a, color);
 	setstroke(color);
+	vgcheck("Stroke");
 }
 
 // Fill sets the fillcolor, defined as a RGBA quad.
@@ -380,6 +1043,30 @@ void Fill(unsigned int r, unsigned int g, unsigned int b, VGfloat a) {
 	VGfloat color[4];
 	RGBA(r, g, b, a, color);
 	setfill(color);
+	vgcheck("Fill");
+}
+
+// ColorPaint makes a paint of a color, defined as a RGBA quad, to be set by FillPaint
+// and StrokePaint without making a new paint each time. Free it with vgDestroyPaint.
+VGPaint ColorPaint(unsigned int r, unsigned int g, unsigned int b, VGfloat a) {
+	VGfloat color[4];
+	VGPaint paint = vgCreatePaint();
+	RGBA(r, g, b, a, color);
+	vgSetParameteri(paint, VG_PAINT_TYPE, VG_PAINT_TYPE_COLOR);
+	vgSetParameterfv(paint, VG_PAINT_COLOR, 4, color);
+	return paint;
+}
+
+// FillPaint sets the fill to a paint made by ColorPaint
+void FillPaint(VGPaint paint) {
+	vgSetPaint(paint, VG_FILL_PATH);
+	vgcheck("FillPaint");
+}
+
+// StrokePaint sets the stroke to a paint made by ColorPaint
+void StrokePaint(VGPaint paint) {
+	vgSetPaint(paint, VG_STROKE_PATH);
+	vgcheck("StrokePaint");
 }
 
 // setstops sets color stops for gradients
@@ -400,6 +1087,7 @@ void FillLinearGradient(VGfloat x1, VGfloat y1, VGfloat x2, VGfloat y2, VGfloat
 	vgSetParameterfv(paint, VG_PAINT_LINEAR_GRADIENT, 4, lgcoord);
 	setstop(paint, stops, ns);
 	vgDestroyPaint(paint);
+	vgcheck("FillLinearGradient");
 }
 
 // RadialGradient fills with a linear gradient
@@ -410,59 +1098,227 @@ void FillRadialGradient(VGfloat cx, VGfloat cy, VGfloat fx, VGfloat fy, VGfloat
 	vgSetParameterfv(paint, VG_PAINT_RADIAL_GRADIENT, 5, radialcoord);
 	setstop(paint, stops, ns);
 	vgDestroyPaint(paint);
+	vgcheck("FillRadialGradient");
+}
+
+//
+// Damage: redrawing only what changed
+//
+
+#define DAMAGE_MAX 16					   // rectangles kept, within OpenVG's minimum of 32 scissor rectangles
+
+typedef struct {
+	VGint x0, y0, x1, y1;				   // window pixels, x1 and y1 excluded
+} Damage;
+
+static Damage damage[DAMAGE_MAX];			   // for the next StartDamaged
+static int ndamage = 0;
+static Damage drawing[DAMAGE_MAX];			   // limiting this frame, until End
+static int ndrawing = 0;
+static int damaging = 0;
+
+// damagearea returns the area of a rectangle
+static long damagearea(const Damage * d) {
+	return (long)(d->x1 - d->x0) * (d->y1 - d->y0);
+}
+
+// damageclamp converts a coordinate to pixels from 0 to max
+static VGint damageclamp(VGfloat v, VGint max) {
+	return v <= 0 ? 0 : v >= max ? max : (VGint) v;
+}
+
+// damageunion grows d to include e
+static void damageunion(Damage * d, const Damage * e) {
+	d->x0 = e->x0 < d->x0 ? e->x0 : d->x0;
+	d->y0 = e->y0 < d->y0 ? e->y0 : d->y0;
+	d->x1 = e->x1 > d->x1 ? e->x1 : d->x1;
+	d->y1 = e->y1 > d->y1 ? e->y1 : d->y1;
+}
+
+// setscissor limits drawing to n rectangles, intersected with clip if not NULL
+static void setscissor(const Damage * d, int n, const Damage * clip) {
+	VGint rects[DAMAGE_MAX * 4];
+	Damage r;
+	int i, k = 0;
+
+	for (i = 0; i < n; i++) {
+		r = d[i];
+		if (clip != NULL) {
+			r.x0 = clip->x0 > r.x0 ? clip->x0 : r.x0;
+			r.y0 = clip->y0 > r.y0 ? clip->y0 : r.y0;
+			r.x1 = clip->x1 < r.x1 ? clip->x1 : r.x1;
+			r.y1 = clip->y1 < r.y1 ? clip->y1 : r.y1;
+			if (r.x0 >= r.x1 || r.y0 >= r.y1) {
+				continue;
+			}
+		}
+		rects[k++] = r.x0;
+		rects[k++] = r.y0;
+		rects[k++] = r.x1 - r.x0;
+		rects[k++] = r.y1 - r.y0;
+	}
+	vgSeti(VG_SCISSORING, VG_TRUE);
+	vgSetiv(VG_SCISSOR_RECTS, k, rects);		   // none, and nothing is drawn
+}
+
+// InvalidateRect marks a rectangle of the window, in window coordinates (not affected by
+// transformations), to be redrawn by the next StartDamaged. Overlapping rectangles are merged,
+// and when there are too many, the two that grow least are.
+void InvalidateRect(VGfloat x, VGfloat y, VGfloat w, VGfloat h) {
+	Damage d, u;
+	long grow, best = -1;
+	int i, bi = 0;
+
+	if (!(w > 0 && h > 0)) {
+		return;					   // also not a number
+	}
+	// a pixel more each way, for antialiased edges, within the window
+	d.x0 = damageclamp(floorf(x) - 1, state->window_width);
+	d.y0 = damageclamp(floorf(y) - 1, state->window_height);
+	d.x1 = damageclamp(ceilf(x + w) + 1, state->window_width);
+	d.y1 = damageclamp(ceilf(y + h) + 1, state->window_height);
+	if (d.x0 >= d.x1 || d.y0 >= d.y1) {
+		return;
+	}
+	for (i = 0; i < ndamage; i++) {
+		if (d.x0 < damage[i].x1 && damage[i].x0 < d.x1 && d.y0 < damage[i].y1 && damage[i].y0 < d.y1) {
+			damageunion(&d, &damage[i]);	   // take it out, and look again with the union
+			damage[i] = damage[--ndamage];
+			i = -1;
+		}
+	}
+	if (ndamage < DAMAGE_MAX) {
+		damage[ndamage++] = d;
+		return;
+	}
+	for (i = 0; i < ndamage; i++) {
+		u = damage[i];
+		damageunion(&u, &d);
+		grow = damagearea(&u) - damagearea(&damage[i]);
+		if (best < 0 || grow < best) {
+			best = grow;
+			bi = i;
+		}
+	}
+	damageunion(&damage[bi], &d);
+}
+
+// InvalidateWindow marks the whole window to be redrawn by the next StartDamaged
+void InvalidateWindow() {
+	ndamage = 1;
+	damage[0].x0 = damage[0].y0 = 0;
+	damage[0].x1 = state->window_width;
+	damage[0].y1 = state->window_height;
 }
 
-// ClipRect limits the drawing area to specified rectangle
+// enddamage stops limiting drawing to the damage, at the end of the frame
+static void enddamage() {
+	if (damaging) {
+		vgSeti(VG_SCISSORING, VG_FALSE);
+		damaging = 0;
+	}
+}
+
+// StartDamaged begins the picture as Start, but clears and draws only within the rectangles
+// invalidated since the last StartDamaged, until End; the rest of the window keeps the last frame.
+// When the buffers are not preserved on swap (see initSurface) there is no last frame to keep,
+// so it is all redrawn. Returns the number of rectangles; with none, nothing changed, and no
+// picture is begun: skip drawing the frame and End.
+int StartDamaged(int width, int height) {
+	int n;
+
+	if (!state->preserved) {
+		InvalidateWindow();
+	}
+	n = ndamage;
+	if (n == 0) {
+		return 0;
+	}
+
+	memcpy(drawing, damage, n * sizeof(Damage));
+	ndrawing = n;
+	ndamage = 0;
+	enddamage();
+	setscissor(drawing, ndrawing, NULL);
+	Start(width, height);				   // clearing within the scissor
+	damaging = 1;
+	return n;
+}
+
+// ClipRect limits the drawing area to specified rectangle, within the damage after StartDamaged
 void ClipRect(VGint x, VGint y, VGint w, VGint h) {
+	Damage clip = { x, y, x + w, y + h };
+
+	if (damaging) {
+		setscissor(drawing, ndrawing, &clip);
+		vgcheck("ClipRect");
+		return;
+	}
 	vgSeti(VG_SCISSORING, VG_TRUE);
 	VGint coords[4] = { x, y, w, h };
 	vgSetiv(VG_SCISSOR_RECTS, 4, coords);
+	vgcheck("ClipRect");
 }
 
 // ClipEnd stops limiting drawing area to specified rectangle
 void ClipEnd() {
+	if (damaging) {
+		setscissor(drawing, ndrawing, NULL);
+		vgcheck("ClipEnd");
+		return;
+	}
 	vgSeti(VG_SCISSORING, VG_FALSE);
+	vgcheck("ClipEnd");
 }
 
 // Text Functions
 
-// next_utf_char handles UTF encoding
-unsigned char *next_utf8_char(unsigned char *utf8, int *codepoint) {
+// next_utf8_char decodes the character at utf8 into codepoint, returning the one after it,
+// or NULL at end, a NUL, or a sequence that is not understood or runs past end
+static const unsigned char *next_utf8_char(const unsigned char *utf8, const unsigned char *end, int *codepoint) {
 	int seqlen;
-	int datalen = (int)strlen((const char *)utf8);
-	unsigned char *p = utf8;
 
-	if (datalen < 1 || *utf8 == 0) {		   // End of string
+	if (utf8 >= end || *utf8 == 0) {		   // End of string
 		return NULL;
 	}
 	if (!(utf8[0] & 0x80)) {			   // 0xxxxxxx
-		*codepoint = (wchar_t) utf8[0];
 		seqlen = 1;
 	} else if ((utf8[0] & 0xE0) == 0xC0) {		   // 110xxxxx 
-		*codepoint = (int)(((utf8[0] & 0x1F) << 6) | (utf8[1] & 0x3F));
 		seqlen = 2;
 	} else if ((utf8[0] & 0xF0) == 0xE0) {		   // 1110xxxx
-		*codepoint = (int)(((utf8[0] & 0x0F) << 12) | ((utf8[1] & 0x3F) << 6) | (utf8[2] & 0x3F));
 		seqlen = 3;
 	} else {
 		return NULL;				   // No code points this high here
 	}
-	p += seqlen;
-	return p;
+	if (end - utf8 < seqlen) {
+		return NULL;
+	}
+	switch (seqlen) {
+	case 1:
+		*codepoint = utf8[0];
+		break;
+	case 2:
+		*codepoint = (int)(((utf8[0] & 0x1F) << 6) | (utf8[1] & 0x3F));
+		break;
+	default:
+		*codepoint = (int)(((utf8[0] & 0x0F) << 12) | ((utf8[1] & 0x3F) << 6) | (utf8[2] & 0x3F));
+	}
+	return utf8 + seqlen;
 }
 
-// Text renders a string of text at a specified location, size, using the specified font glyphs
+// TextN renders the n bytes of text at s, which need not be NUL terminated, at a specified location,
+// size, using the specified font glyphs
 // derived from http://web.archive.org/web/20070808195131/http://developer.hybrid.fi/font2openvg/renderFont.cpp.txt
-void Text(VGfloat x, VGfloat y, const char *s, Fontinfo f, int pointsize) {
+void TextN(VGfloat x, VGfloat y, const char *s, int n, Fontinfo f, int pointsize) {
 	VGfloat size = (VGfloat) pointsize, xx = x, mm[9];
 	vgGetMatrix(mm);
 	int character;
-	unsigned char *ss = (unsigned char *)s;
-	while ((ss = next_utf8_char(ss, &character)) != NULL) {
-		int glyph = f.CharacterMap[character];
+	const unsigned char *ss = (const unsigned char *)s, *end = ss + n;
+	while ((ss = next_utf8_char(ss, end, &character)) != NULL) {
 		if (character >= MAXFONTPATH-1) {
 			continue;
 		}
+		int glyph = f.CharacterMap[character];
 		if (glyph == -1) {
 			continue;			   //glyph is undefined
 		}
@@ -477,19 +1333,25 @@ void Text(VGfloat x, VGfloat y, const char *s, Fontinfo f, int pointsize) {
 		xx += size * f.GlyphAdvances[glyph] / 65536.0f;
 	}
 	vgLoadMatrix(mm);
+	vgcheck("TextN");
 }
 
-// TextWidth returns the width of a text string at the specified font and size.
-VGfloat TextWidth(const char *s, Fontinfo f, int pointsize) {
+// Text renders a string of text at a specified location, size, using the specified font glyphs
+void Text(VGfloat x, VGfloat y, const char *s, Fontinfo f, int pointsize) {
+	TextN(x, y, s, strlen(s), f, pointsize);
+}
+
+// TextWidthN returns the width of the n bytes of text at s, at the specified font and size.
+VGfloat TextWidthN(const char *s, int n, Fontinfo f, int pointsize) {
 	VGfloat tw = 0.0;
 	VGfloat size = (VGfloat) pointsize;
 	int character;
-	unsigned char *ss = (unsigned char *)s;
-	while ((ss = next_utf8_char(ss, &character)) != NULL) {
-		int glyph = f.CharacterMap[character];
+	const unsigned char *ss = (const unsigned char *)s, *end = ss + n;
+	while ((ss = next_utf8_char(ss, end, &character)) != NULL) {
 		if (character >= MAXFONTPATH-1) {
 			continue;
 		}
+		int glyph = f.CharacterMap[character];
 		if (glyph == -1) {
 			continue;			   //glyph is undefined
 		}
@@ -498,16 +1360,31 @@ VGfloat TextWidth(const char *s, Fontinfo f, int pointsize) {
 	return tw;
 }
 
+// TextWidth returns the width of a text string at the specified font and size.
+VGfloat TextWidth(const char *s, Fontinfo f, int pointsize) {
+	return TextWidthN(s, strlen(s), f, pointsize);
+}
+
+// TextMidN draws n bytes of text, centered on (x,y)
+void TextMidN(VGfloat x, VGfloat y, const char *s, int n, Fontinfo f, int pointsize) {
+	VGfloat tw = TextWidthN(s, n, f, pointsize);
+	TextN(x - (tw / 2.0), y, s, n, f, pointsize);
+}
+
 // TextMid draws text, centered on (x,y)
 void TextMid(VGfloat x, VGfloat y, const char *s, Fontinfo f, int pointsize) {
-	VGfloat tw = TextWidth(s, f, pointsize);
-	Text(x - (tw / 2.0), y, s, f, pointsize);
+	TextMidN(x, y, s, strlen(s), f, pointsize);
+}
+
+// TextEndN draws n bytes of text, with its end aligned to (x,y)
+void TextEndN(VGfloat x, VGfloat y, const char *s, int n, Fontinfo f, int pointsize) {
+	VGfloat tw = TextWidthN(s, n, f, pointsize);
+	TextN(x - tw, y, s, n, f, pointsize);
 }
 
 // TextEnd draws text, with its end aligned to (x,y)
 void TextEnd(VGfloat x, VGfloat y, const char *s, Fontinfo f, int pointsize) {
-	VGfloat tw = TextWidth(s, f, pointsize);
-	Text(x - tw, y, s, f, pointsize);
+	TextEndN(x, y, s, strlen(s), f, pointsize);
 }
 
 // TextHeight reports a font's height
@@ -544,6 +1421,7 @@ void Cbezier(VGfloat sx, VGfloat sy, VGfloat cx, VGfloat cy, VGfloat px, VGfloat
 	VGubyte segments[] = { VG_MOVE_TO_ABS, VG_CUBIC_TO };
 	VGfloat coords[] = { sx, sy, cx, cy, px, py, ex, ey };
 	makecurve(segments, coords, VG_FILL_PATH | VG_STROKE_PATH);
+	vgcheck("Cbezier");
 }
 
 // QBezier makes a quadratic bezier curve
@@ -551,6 +1429,7 @@ void Qbezier(VGfloat sx, VGfloat sy, VGfloat cx, VGfloat cy, VGfloat ex, VGfloat
 	VGubyte segments[] = { VG_MOVE_TO_ABS, VG_QUAD_TO };
 	VGfloat coords[] = { sx, sy, cx, cy, ex, ey };
 	makecurve(segments, coords, VG_FILL_PATH | VG_STROKE_PATH);
+	vgcheck("Qbezier");
 }
 
 // interleave interleaves arrays of x, y into a single array
@@ -574,11 +1453,13 @@ void poly(VGfloat * x, VGfloat * y, VGint n, VGbitfield flag) {
 // Polygon makes a filled polygon with vertices in x, y arrays
 void Polygon(VGfloat * x, VGfloat * y, VGint n) {
 	poly(x, y, n, VG_FILL_PATH);
+	vgcheck("Polygon");
 }
 
 // Polyline makes a polyline with vertices at x, y arrays
 void Polyline(VGfloat * x, VGfloat * y, VGint n) {
 	poly(x, y, n, VG_STROKE_PATH);
+	vgcheck("Polyline");
 }
 
 // Rect makes a rectangle at the specified location and dimensions
@@ -587,6 +1468,7 @@ void Rect(VGfloat x, VGfloat y, VGfloat w, VGfloat h) {
 	vguRect(path, x, y, w, h);
 	vgDrawPath(path, VG_FILL_PATH | VG_STROKE_PATH);
 	vgDestroyPath(path);
+	vgcheck("Rect");
 }
 
 // Line makes a line from (x1,y1) to (x2,y2)
@@ -595,6 +1477,7 @@ void Line(VGfloat x1, VGfloat y1, VGfloat x2, VGfloat y2) {
 	vguLine(path, x1, y1, x2, y2);
 	vgDrawPath(path, VG_STROKE_PATH);
 	vgDestroyPath(path);
+	vgcheck("Line");
 }
 
 // Roundrect makes an rounded rectangle at the specified location and dimensions
@@ -603,6 +1486,7 @@ void Roundrect(VGfloat x, VGfloat y, VGfloat w, VGfloat h, VGfloat rw, VGfloat r
 	vguRoundRect(path, x, y, w, h, rw, rh);
 	vgDrawPath(path, VG_FILL_PATH | VG_STROKE_PATH);
 	vgDestroyPath(path);
+	vgcheck("Roundrect");
 }
 
 // Ellipse makes an ellipse at the specified location and dimensions
@@ -611,6 +1495,7 @@ void Ellipse(VGfloat x, VGfloat y, VGfloat w, VGfloat h) {
 	vguEllipse(path, x, y, w, h);
 	vgDrawPath(path, VG_FILL_PATH | VG_STROKE_PATH);
 	vgDestroyPath(path);
+	vgcheck("Ellipse");
 }
 
 // Circle makes a circle at the specified location and dimensions
@@ -624,11 +1509,13 @@ void Arc(VGfloat x, VGfloat y, VGfloat w, VGfloat h, VGfloat sa, VGfloat aext) {
 	vguArc(path, x, y, w, h, sa, aext, VGU_ARC_OPEN);
 	vgDrawPath(path, VG_FILL_PATH | VG_STROKE_PATH);
 	vgDestroyPath(path);
+	vgcheck("Arc");
 }
 
 // Start begins the picture, clearing a rectangular region with a specified color
 void Start(int width, int height) {
 	VGfloat color[4] = { 1, 1, 1, 1 };
+	enddamage();					   // from a StartDamaged frame that was skipped
 	vgSetfv(VG_CLEAR_COLOR, 4, color);
 	vgClear(0, 0, width, height);
 	color[0] = 0, color[1] = 0, color[2] = 0;
@@ -636,30 +1523,37 @@ void Start(int width, int height) {
 	setstroke(color);
 	StrokeWidth(0);
 	vgLoadIdentity();
+	vgcheck("Start");
 }
 
-// End checks for errors, and renders to the display
+// End checks for errors, as ErrorPolicy has it, and renders to the display
 void End() {
-	assert(vgGetError() == VG_NO_ERROR);
-	eglSwapBuffers(state->display, state->surface);
-	assert(eglGetError() == EGL_SUCCESS);
+	enddamage();
+	framecheck("End");
+	swapcheck(frameswap(state));
+}
+
+// FrameVsync paces End to every nth vertical sync of the display, woken by a dispmanx vsync
+// callback rather than spinning; 0 stops. Returns 0, or -1 if the callback is not available.
+int FrameVsync(int n) {
+	return framevsync(state, n);
 }
 
 // SaveEnd dumps the raster before rendering to the display 
 void SaveEnd(const char *filename) {
 	FILE *fp;
-	assert(vgGetError() == VG_NO_ERROR);
+	enddamage();
+	framecheck("SaveEnd");
 	if (strlen(filename) == 0) {
-		dumpscreen(state->screen_width, state->screen_height, stdout);
+		dumpscreen(state->window_width, state->window_height, stdout);
 	} else {
 		fp = fopen(filename, "wb");
 		if (fp != NULL) {
-			dumpscreen(state->screen_width, state->screen_height, fp);
+			dumpscreen(state->window_width, state->window_height, fp);
 			fclose(fp);
 		}
 	}
-	eglSwapBuffers(state->display, state->surface);
-	assert(eglGetError() == EGL_SUCCESS);
+	swapcheck(frameswap(state));
 }
 
 // Backgroud clears the screen to a solid background color
@@ -668,6 +1562,7 @@ void Background(unsigned int r, unsigned int g, unsigned int b) {
 	RGB(r, g, b, colour);
 	vgSetfv(VG_CLEAR_COLOR, 4, colour);
 	vgClear(0, 0, state->window_width, state->window_height);
+	vgcheck("Background");
 }
 
 // BackgroundRGB clears the screen to a background color with alpha
@@ -676,17 +1571,20 @@ void BackgroundRGB(unsigned int r, unsigned int g, unsigned int b, VGfloat a) {
 	RGBA(r, g, b, a, colour);
 	vgSetfv(VG_CLEAR_COLOR, 4, colour);
 	vgClear(0, 0, state->window_width, state->window_height);
+	vgcheck("BackgroundRGB");
 }
 
 // WindowClear clears the window to previously set background colour
 void WindowClear() {
 	vgClear(0, 0, state->window_width, state->window_height);
+	vgcheck("WindowClear");
 }
 
 // AreaClear clears a given rectangle in window coordinates (not affected by
 // transformations)
 void AreaClear(unsigned int x, unsigned int y, unsigned int w, unsigned int h) {
 	vgClear(x, y, w, h);
+	vgcheck("AreaClear");
 }
 
 // WindowOpacity sets the  window opacity
@@ -709,6 +1607,7 @@ void CbezierOutline(VGfloat sx, VGfloat sy, VGfloat cx, VGfloat cy, VGfloat px,
 	VGubyte segments[] = { VG_MOVE_TO_ABS, VG_CUBIC_TO };
 	VGfloat coords[] = { sx, sy, cx, cy, px, py, ex, ey };
 	makecurve(segments, coords, VG_STROKE_PATH);
+	vgcheck("CbezierOutline");
 }
 
 // QBezierOutline makes a quadratic bezier curve, outlined 
@@ -716,6 +1615,7 @@ void QbezierOutline(VGfloat sx, VGfloat sy, VGfloat cx, VGfloat cy, VGfloat ex,
 	VGubyte segments[] = { VG_MOVE_TO_ABS, VG_QUAD_TO };
 	VGfloat coords[] = { sx, sy, cx, cy, ex, ey };
 	makecurve(segments, coords, VG_STROKE_PATH);
+	vgcheck("QbezierOutline");
 }
 
 // RectOutline makes a rectangle at the specified location and dimensions, outlined 
@@ -724,6 +1624,7 @@ void RectOutline(VGfloat x, VGfloat y, VGfloat w, VGfloat h) {
 	vguRect(path, x, y, w, h);
 	vgDrawPath(path, VG_STROKE_PATH);
 	vgDestroyPath(path);
+	vgcheck("RectOutline");
 }
 
 // RoundrectOutline  makes an rounded rectangle at the specified location and dimensions, outlined 
@@ -732,6 +1633,7 @@ void RoundrectOutline(VGfloat x, VGfloat y, VGfloat w, VGfloat h, VGfloat rw, VG
 	vguRoundRect(path, x, y, w, h, rw, rh);
 	vgDrawPath(path, VG_STROKE_PATH);
 	vgDestroyPath(path);
+	vgcheck("RoundrectOutline");
 }
 
 // EllipseOutline makes an ellipse at the specified location and dimensions, outlined
@@ -740,6 +1642,7 @@ void EllipseOutline(VGfloat x, VGfloat y, VGfloat w, VGfloat h) {
 	vguEllipse(path, x, y, w, h);
 	vgDrawPath(path, VG_STROKE_PATH);
 	vgDestroyPath(path);
+	vgcheck("EllipseOutline");
 }
 
 // CircleOutline makes a circle at the specified location and dimensions, outlined
@@ -753,4 +1656,5 @@ void ArcOutline(VGfloat x, VGfloat y, VGfloat w, VGfloat h, VGfloat sa, VGfloat
 	vguArc(path, x, y, w, h, sa, aext, VGU_ARC_OPEN);
 	vgDrawPath(path, VG_STROKE_PATH);
 	vgDestroyPath(path);
+	vgcheck("ArcOutline");
 }
@@ -0,0 +1,153 @@
+//
+// mipmap: scaled image drawing
+//
+// A MipImage keeps the image at full size and at each halving down to
+// a pixel, built once on the CPU; drawing it small samples the nearest
+// larger level, not the full size source.
+//
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+#include "vgcheck.h"
+
+#define MIP_LEVELS 16
+
+struct MipImage {
+	VGImage level[MIP_LEVELS];
+	int width[MIP_LEVELS];
+	int height[MIP_LEVELS];
+	int levels;
+};
+
+// DrawImageScaled draws an image with its lower left corner at (x,y), scaled to (w,h),
+// blended and transformed like shapes.
+void DrawImageScaled(VGImage img, VGfloat x, VGfloat y, VGfloat w, VGfloat h) {
+	VGfloat mm[9];
+	VGint quality;
+	VGint iw = vgGetParameteri(img, VG_IMAGE_WIDTH);
+	VGint ih = vgGetParameteri(img, VG_IMAGE_HEIGHT);
+
+	if (iw <= 0 || ih <= 0) {
+		return;
+	}
+	vgGetMatrix(mm);
+	quality = vgGeti(VG_IMAGE_QUALITY);
+	vgSeti(VG_IMAGE_QUALITY, VG_IMAGE_QUALITY_BETTER);
+	vgSeti(VG_MATRIX_MODE, VG_MATRIX_IMAGE_USER_TO_SURFACE);
+	vgLoadMatrix(mm);
+	vgTranslate(x, y);
+	vgScale(w / iw, h / ih);
+	vgDrawImage(img);
+	vgSeti(VG_MATRIX_MODE, VG_MATRIX_PATH_USER_TO_SURFACE);
+	vgSeti(VG_IMAGE_QUALITY, quality);
+	vgcheck("DrawImageScaled");
+}
+
+// MipImageCreate makes a mip image from a w x h raster of red, green, blue, alpha values
+// (bottom row first, stride bytes per row); alphamode is as for createImage.
+// Translucent rasters should be premultiplied, so that the averages do not pick up
+// the color of transparent pixels.
+MipImage *MipImageCreate(const VGubyte * data, int w, int h, int stride, int alphamode) {
+	MipImage *m;
+	VGubyte *buf[2];
+	int i, y;
+
+	if (w <= 0 || h <= 0) {
+		return NULL;
+	}
+	// even levels are built in buf[0], odd levels in buf[1]
+	m = (MipImage *) calloc(1, sizeof(MipImage));
+	buf[0] = (VGubyte *) malloc(w * h * 4);
+	buf[1] = (VGubyte *) malloc(((w + 1) / 2) * ((h + 1) / 2) * 4);
+	if (m == NULL || buf[0] == NULL || buf[1] == NULL) {
+		free(m);
+		free(buf[0]);
+		free(buf[1]);
+		return NULL;
+	}
+	for (y = 0; y < h; y++) {
+		if (alphamode == ALPHA_PREMULTIPLY) {
+			PremultiplyRGBA(buf[0] + y * w * 4, data + y * stride, w);
+		} else {
+			memcpy(buf[0] + y * w * 4, data + y * stride, w * 4);
+		}
+	}
+	if (alphamode == ALPHA_PREMULTIPLY) {
+		alphamode = ALPHA_PREMULTIPLIED;
+	}
+	for (i = 0; i < MIP_LEVELS; i++) {
+		m->level[i] = createImage(buf[i & 1], w, h, w * 4, alphamode);
+		if (m->level[i] == VG_INVALID_HANDLE) {
+			break;
+		}
+		m->width[i] = w;
+		m->height[i] = h;
+		m->levels++;
+		if (w == 1 && h == 1) {
+			break;
+		}
+		HalveRGBA(buf[(i + 1) & 1], ((w + 1) / 2) * 4, buf[i & 1], w * 4, w, h);
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+	}
+	free(buf[0]);
+	free(buf[1]);
+	if (m->levels == 0) {
+		free(m);
+		return NULL;
+	}
+	return m;
+}
+
+// MipImageFromJpeg makes a mip image from a JPEG file
+MipImage *MipImageFromJpeg(const char *filename) {
+	MipImage *m;
+	VGubyte *data;
+	int w, h;
+
+	data = decodeJpeg(filename, &w, &h);
+	if (data == NULL) {
+		return NULL;
+	}
+	m = MipImageCreate(data, w, h, w * 4, ALPHA_PREMULTIPLIED);	// JPEGs are opaque
+	free(data);
+	return m;
+}
+
+// MipImageSize returns the full size dimensions
+void MipImageSize(MipImage * m, int *w, int *h) {
+	*w = m->width[0];
+	*h = m->height[0];
+}
+
+// MipImageDraw draws the image at (x,y) scaled to (w,h), from the smallest level
+// that is at least that size on the screen, under the current transformation.
+void MipImageDraw(MipImage * m, VGfloat x, VGfloat y, VGfloat w, VGfloat h) {
+	VGfloat mm[9], sx, sy;
+	int i = 0;
+
+	vgGetMatrix(mm);
+	sx = fabsf(w) * sqrtf(mm[0] * mm[0] + mm[1] * mm[1]);
+	sy = fabsf(h) * sqrtf(mm[3] * mm[3] + mm[4] * mm[4]);
+	while (i + 1 < m->levels && m->width[i + 1] >= sx && m->height[i + 1] >= sy) {
+		i++;
+	}
+	DrawImageScaled(m->level[i], x, y, w, h);
+}
+
+// MipImageDestroy frees all the levels
+void MipImageDestroy(MipImage * m) {
+	int i;
+
+	if (m == NULL) {
+		return;
+	}
+	for (i = 0; i < m->levels; i++) {
+		vgDestroyImage(m->level[i]);
+	}
+	free(m);
+}
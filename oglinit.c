@@ -2,6 +2,9 @@
 #include "eglstate.h"
 #include <bcm_host.h>
 #include <assert.h>
+#include "shapes.h"
+
+#define MAXCONFIGS 64					   // considered by chooseconfig
 
 // setWindowParams sets the window's position, adjusting if need be to
 // prevent it from going fully off screen. Also sets the dispman rects
@@ -66,12 +69,35 @@ static void setWindowParams(STATE_T * state, int x, int y, VC_RECT_T * src_rect,
 	vc_dispmanx_rect_set(src_rect, sx << 16, sy << 16, w << 16, h << 16);
 }
 
+// chooseconfig returns a config matching attribs, with exactly the color sizes in it if there is one:
+// eglChooseConfig takes sizes as minimums, and sorts the deepest configs first.
+// Returns NULL if none match.
+static EGLConfig chooseconfig(EGLDisplay display, const EGLint * attribs, EGLint r, EGLint g, EGLint b, EGLint a) {
+	static const EGLint sizes[4] = { EGL_RED_SIZE, EGL_GREEN_SIZE, EGL_BLUE_SIZE, EGL_ALPHA_SIZE };
+	EGLConfig configs[MAXCONFIGS];
+	EGLint want[4] = { r, g, b, a }, v, n, i, j;
+
+	if (eglChooseConfig(display, attribs, configs, MAXCONFIGS, &n) == EGL_FALSE || n < 1) {
+		return NULL;
+	}
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < 4; j++) {
+			if (eglGetConfigAttrib(display, configs[i], sizes[j], &v) == EGL_FALSE || v != want[j]) {
+				break;
+			}
+		}
+		if (j == 4) {
+			return configs[i];
+		}
+	}
+	return configs[0];
+}
+
 // oglinit sets the display, OpenVGL context and screen information
 // state holds the display information
 void oglinit(STATE_T * state) {
 	int32_t success = 0;
 	EGLBoolean result;
-	EGLint num_config;
 
 	static EGL_DISPMANX_WINDOW_T nativewindow;
 
@@ -85,12 +111,19 @@ void oglinit(STATE_T * state) {
 		255, 0
 	};
 
-	static const EGLint attribute_list[] = {
-		EGL_RED_SIZE, 8,
-		EGL_GREEN_SIZE, 8,
-		EGL_BLUE_SIZE, 8,
-		EGL_ALPHA_SIZE, 8,
+	// RGBA8888 unless initSurface asks for less
+	EGLint rgb565 = state->surface_flags & SURFACE_RGB565;
+	EGLint red = rgb565 ? 5 : 8, green = rgb565 ? 6 : 8, blue = rgb565 ? 5 : 8;
+	EGLint alphasize = rgb565 || (state->surface_flags & SURFACE_OPAQUE) ? 0 : 8;
+	EGLint attribute_list[] = {
+		EGL_RED_SIZE, red,
+		EGL_GREEN_SIZE, green,
+		EGL_BLUE_SIZE, blue,
+		EGL_ALPHA_SIZE, alphasize,
 		EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENVG_BIT,
+		EGL_SAMPLE_BUFFERS, state->samples > 1,
+		EGL_SAMPLES, state->samples > 1 ? state->samples : 0,
 		EGL_NONE
 	};
 
@@ -107,9 +140,14 @@ void oglinit(STATE_T * state) {
 	// bind OpenVG API
 	eglBindAPI(EGL_OPENVG_API);
 
-	// get an appropriate EGL frame buffer configuration
-	result = eglChooseConfig(state->display, attribute_list, &config, 1, &num_config);
-	assert(EGL_FALSE != result);
+	// get an appropriate EGL frame buffer configuration, without multisampling if there is none with it
+	config = chooseconfig(state->display, attribute_list, red, green, blue, alphasize);
+	if (config == NULL && state->samples > 1) {
+		state->samples = 0;
+		attribute_list[13] = attribute_list[15] = 0;	// EGL_SAMPLE_BUFFERS, EGL_SAMPLES
+		config = chooseconfig(state->display, attribute_list, red, green, blue, alphasize);
+	}
+	assert(config != NULL);
 
 	// create an EGL rendering context
 	state->context = eglCreateContext(state->display, config, EGL_NO_CONTEXT, NULL);
@@ -137,6 +175,7 @@ void oglinit(STATE_T * state) {
 						  0 /*transform */ );
 
 	state->element = dispman_element;
+	state->dispman_display = dispman_display;
 	nativewindow.element = dispman_element;
 	nativewindow.width = state->window_width;
 	nativewindow.height = state->window_height;
@@ -145,13 +184,20 @@ void oglinit(STATE_T * state) {
 	state->surface = eglCreateWindowSurface(state->display, config, &nativewindow, NULL);
 	assert(state->surface != EGL_NO_SURFACE);
 
-	// preserve the buffers on swap
-	result = eglSurfaceAttrib(state->display, state->surface, EGL_SWAP_BEHAVIOR, EGL_BUFFER_PRESERVED);
-	assert(EGL_FALSE != result);
+	// preserve the buffers on swap, unless initSurface says the whole frame is redrawn, which saves
+	// copying the last frame into the new buffer; if the config cannot preserve them, they are not
+	state->preserved = !(state->surface_flags & SURFACE_DISCARD)
+	    && eglSurfaceAttrib(state->display, state->surface, EGL_SWAP_BEHAVIOR, EGL_BUFFER_PRESERVED) != EGL_FALSE;
+	if (!state->preserved) {
+		eglSurfaceAttrib(state->display, state->surface, EGL_SWAP_BEHAVIOR, EGL_BUFFER_DESTROYED);
+	}
 
 	// connect the context to the surface
 	result = eglMakeCurrent(state->display, state->surface, state->surface, state->context);
 	assert(EGL_FALSE != result);
+
+	// vertical syncs from one swap to the next, for the current surface
+	eglSwapInterval(state->display, state->swap_interval);
 }
 
 // dispmanMoveWindow repositions the openVG window to given coords
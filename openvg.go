@@ -3,24 +3,40 @@ package openvg
 
 /*
 #cgo CFLAGS:   -I/opt/vc/include -I/opt/vc/include/interface/vmcs_host/linux -I/opt/vc/include/interface/vcos/pthreads
-#cgo LDFLAGS:  -L/opt/vc/lib -lbrcmGLESv2 -lbrcmEGL -lbcm_host -ljpeg
+#cgo LDFLAGS:  -L/opt/vc/lib -lbrcmGLESv2 -lbrcmEGL -lbcm_host -ljpeg -lpthread -lrt -lz -lm
 #include "VG/openvg.h"
 #include "VG/vgu.h"
 #include "EGL/egl.h"
 #include "GLES/gl.h"
 #include "fontinfo.h" // font information
 #include "shapes.h"   // C API
+
+// Go strings are passed to the text functions with their length, without copying to a C string
+static void gotext(VGfloat x, VGfloat y, _GoString_ s, Fontinfo f, int size) {
+	TextN(x, y, _GoStringPtr(s), _GoStringLen(s), f, size);
+}
+static void gotextmid(VGfloat x, VGfloat y, _GoString_ s, Fontinfo f, int size) {
+	TextMidN(x, y, _GoStringPtr(s), _GoStringLen(s), f, size);
+}
+static void gotextend(VGfloat x, VGfloat y, _GoString_ s, Fontinfo f, int size) {
+	TextEndN(x, y, _GoStringPtr(s), _GoStringLen(s), f, size);
+}
+static VGfloat gotextwidth(_GoString_ s, Fontinfo f, int size) {
+	return TextWidthN(_GoStringPtr(s), _GoStringLen(s), f, size);
+}
 */
 import "C"
 import (
 	"fmt"
 	"image"
+	"image/color"
 	_ "image/gif"
 	_ "image/jpeg"
 	_ "image/png"
 	"os"
 	"runtime"
 	"strings"
+	"sync"
 	"unsafe"
 )
 
@@ -41,157 +57,6 @@ type Offcolor struct {
 	Alpha VGfloat
 }
 
-// colornames maps SVG color names to RGB triples.
-var colornames = map[string]RGB{
-	"aliceblue":            {240, 248, 255},
-	"antiquewhite":         {250, 235, 215},
-	"aqua":                 {0, 255, 255},
-	"aquamarine":           {127, 255, 212},
-	"azure":                {240, 255, 255},
-	"beige":                {245, 245, 220},
-	"bisque":               {255, 228, 196},
-	"black":                {0, 0, 0},
-	"blanchedalmond":       {255, 235, 205},
-	"blue":                 {0, 0, 255},
-	"blueviolet":           {138, 43, 226},
-	"brown":                {165, 42, 42},
-	"burlywood":            {222, 184, 135},
-	"cadetblue":            {95, 158, 160},
-	"chartreuse":           {127, 255, 0},
-	"chocolate":            {210, 105, 30},
-	"coral":                {255, 127, 80},
-	"cornflowerblue":       {100, 149, 237},
-	"cornsilk":             {255, 248, 220},
-	"crimson":              {220, 20, 60},
-	"cyan":                 {0, 255, 255},
-	"darkblue":             {0, 0, 139},
-	"darkcyan":             {0, 139, 139},
-	"darkgoldenrod":        {184, 134, 11},
-	"darkgray":             {169, 169, 169},
-	"darkgreen":            {0, 100, 0},
-	"darkgrey":             {169, 169, 169},
-	"darkkhaki":            {189, 183, 107},
-	"darkmagenta":          {139, 0, 139},
-	"darkolivegreen":       {85, 107, 47},
-	"darkorange":           {255, 140, 0},
-	"darkorchid":           {153, 50, 204},
-	"darkred":              {139, 0, 0},
-	"darksalmon":           {233, 150, 122},
-	"darkseagreen":         {143, 188, 143},
-	"darkslateblue":        {72, 61, 139},
-	"darkslategray":        {47, 79, 79},
-	"darkslategrey":        {47, 79, 79},
-	"darkturquoise":        {0, 206, 209},
-	"darkviolet":           {148, 0, 211},
-	"deeppink":             {255, 20, 147},
-	"deepskyblue":          {0, 191, 255},
-	"dimgray":              {105, 105, 105},
-	"dimgrey":              {105, 105, 105},
-	"dodgerblue":           {30, 144, 255},
-	"firebrick":            {178, 34, 34},
-	"floralwhite":          {255, 250, 240},
-	"forestgreen":          {34, 139, 34},
-	"fuchsia":              {255, 0, 255},
-	"gainsboro":            {220, 220, 220},
-	"ghostwhite":           {248, 248, 255},
-	"gold":                 {255, 215, 0},
-	"goldenrod":            {218, 165, 32},
-	"gray":                 {128, 128, 128},
-	"green":                {0, 128, 0},
-	"greenyellow":          {173, 255, 47},
-	"grey":                 {128, 128, 128},
-	"honeydew":             {240, 255, 240},
-	"hotpink":              {255, 105, 180},
-	"indianred":            {205, 92, 92},
-	"indigo":               {75, 0, 130},
-	"ivory":                {255, 255, 240},
-	"khaki":                {240, 230, 140},
-	"lavender":             {230, 230, 250},
-	"lavenderblush":        {255, 240, 245},
-	"lawngreen":            {124, 252, 0},
-	"lemonchiffon":         {255, 250, 205},
-	"lightblue":            {173, 216, 230},
-	"lightcoral":           {240, 128, 128},
-	"lightcyan":            {224, 255, 255},
-	"lightgoldenrodyellow": {250, 250, 210},
-	"lightgray":            {211, 211, 211},
-	"lightgreen":           {144, 238, 144},
-	"lightgrey":            {211, 211, 211},
-	"lightpink":            {255, 182, 193},
-	"lightsalmon":          {255, 160, 122},
-	"lightseagreen":        {32, 178, 170},
-	"lightskyblue":         {135, 206, 250},
-	"lightslategray":       {119, 136, 153},
-	"lightslategrey":       {119, 136, 153},
-	"lightsteelblue":       {176, 196, 222},
-	"lightyellow":          {255, 255, 224},
-	"lime":                 {0, 255, 0},
-	"limegreen":            {50, 205, 50},
-	"linen":                {250, 240, 230},
-	"magenta":              {255, 0, 255},
-	"maroon":               {128, 0, 0},
-	"mediumaquamarine":     {102, 205, 170},
-	"mediumblue":           {0, 0, 205},
-	"mediumorchid":         {186, 85, 211},
-	"mediumpurple":         {147, 112, 219},
-	"mediumseagreen":       {60, 179, 113},
-	"mediumslateblue":      {123, 104, 238},
-	"mediumspringgreen":    {0, 250, 154},
-	"mediumturquoise":      {72, 209, 204},
-	"mediumvioletred":      {199, 21, 133},
-	"midnightblue":         {25, 25, 112},
-	"mintcream":            {245, 255, 250},
-	"mistyrose":            {255, 228, 225},
-	"moccasin":             {255, 228, 181},
-	"navajowhite":          {255, 222, 173},
-	"navy":                 {0, 0, 128},
-	"oldlace":              {253, 245, 230},
-	"olive":                {128, 128, 0},
-	"olivedrab":            {107, 142, 35},
-	"orange":               {255, 165, 0},
-	"orangered":            {255, 69, 0},
-	"orchid":               {218, 112, 214},
-	"palegoldenrod":        {238, 232, 170},
-	"palegreen":            {152, 251, 152},
-	"paleturquoise":        {175, 238, 238},
-	"palevioletred":        {219, 112, 147},
-	"papayawhip":           {255, 239, 213},
-	"peachpuff":            {255, 218, 185},
-	"peru":                 {205, 133, 63},
-	"pink":                 {255, 192, 203},
-	"plum":                 {221, 160, 221},
-	"powderblue":           {176, 224, 230},
-	"purple":               {128, 0, 128},
-	"red":                  {255, 0, 0},
-	"rosybrown":            {188, 143, 143},
-	"royalblue":            {65, 105, 225},
-	"saddlebrown":          {139, 69, 19},
-	"salmon":               {250, 128, 114},
-	"sandybrown":           {244, 164, 96},
-	"seagreen":             {46, 139, 87},
-	"seashell":             {255, 245, 238},
-	"sienna":               {160, 82, 45},
-	"silver":               {192, 192, 192},
-	"skyblue":              {135, 206, 235},
-	"slateblue":            {106, 90, 205},
-	"slategray":            {112, 128, 144},
-	"slategrey":            {112, 128, 144},
-	"snow":                 {255, 250, 250},
-	"springgreen":          {0, 255, 127},
-	"steelblue":            {70, 130, 180},
-	"tan":                  {210, 180, 140},
-	"teal":                 {0, 128, 128},
-	"thistle":              {216, 191, 216},
-	"tomato":               {255, 99, 71},
-	"turquoise":            {64, 224, 208},
-	"violet":               {238, 130, 238},
-	"wheat":                {245, 222, 179},
-	"white":                {255, 255, 255},
-	"whitesmoke":           {245, 245, 245},
-	"yellow":               {255, 255, 0},
-	"yellowgreen":          {154, 205, 50},
-}
-
 // Init initializes the graphics subsystem
 func Init() (int, int) {
 	runtime.LockOSThread()
@@ -205,6 +70,20 @@ func InitWindowSize(x, y, w, h int) {
 	C.initWindowSize(C.int(x), C.int(y), C.uint(w), C.uint(h))
 }
 
+// Surface options, for InitSurface
+const (
+	SurfaceRGB565  = C.SURFACE_RGB565  // 16 bit color, without alpha; half the memory traffic of RGBA8888
+	SurfaceOpaque  = C.SURFACE_OPAQUE  // 24 bit color, without alpha
+	SurfaceDiscard = C.SURFACE_DISCARD // buffers not preserved on swap, for programs that redraw every pixel
+)
+
+// InitSurface sets the window surface's format and swap behavior, before Init: flags are Surface
+// options, samples the multisamples a pixel (0 for none), and interval the vertical syncs from
+// one swap to the next (1 by default; 0 swaps without waiting)
+func InitSurface(flags, samples, interval int) {
+	C.initSurface(C.int(flags), C.int(samples), C.int(interval))
+}
+
 // WindowClear clears the window to previously set background color
 func WindowClear() {
 	C.WindowClear()
@@ -301,22 +180,25 @@ func StrokeWidth(w VGfloat) {
 	C.StrokeWidth(C.VGfloat(w))
 }
 
+//go:generate go run util/mkcolorhash/mkcolorhash.go -f go-client/colortab/svgcolors.txt -o colorhash.go
+
 // Colorlookup returns a RGB triple corresponding to the named color,
 // or "rgb(r,g,b)" string. On error, return black.
+// Names are found in the perfect hash table generated in colorhash.go.
 func Colorlookup(s string) RGB {
-	var rcolor = RGB{0, 0, 0}
-	color, ok := colornames[s]
+	color, ok := svgcolor(s)
 	if ok {
 		return color
 	}
 	if strings.HasPrefix(s, "rgb(") {
+		var rcolor RGB // only this escapes to Sscanf
 		n, err := fmt.Sscanf(s[3:], "(%d,%d,%d)", &rcolor.Red, &rcolor.Green, &rcolor.Blue)
 		if n != 3 || err != nil {
 			return RGB{0, 0, 0}
 		}
 		return rcolor
 	}
-	return rcolor
+	return RGB{0, 0, 0}
 }
 
 // FillColor sets the fill color using names to specify the color, optionally applying alpha.
@@ -339,6 +221,49 @@ func StrokeColor(s string, alpha ...VGfloat) {
 	}
 }
 
+// ColorHandle is a color resolved once from a name or "rgb(r,g,b)" string, with alpha.
+// Its paint is made on the C side when first used, and kept until Destroy.
+type ColorHandle struct {
+	RGB
+	Alpha VGfloat
+	paint C.VGPaint
+}
+
+// NewColor resolves a color name or "rgb(r,g,b)" string, optionally applying alpha
+func NewColor(s string, alpha ...VGfloat) *ColorHandle {
+	c := &ColorHandle{RGB: Colorlookup(s), Alpha: 1}
+	if len(alpha) > 0 {
+		c.Alpha = alpha[0]
+	}
+	return c
+}
+
+// getpaint returns the color's paint, making it the first time
+func (c *ColorHandle) getpaint() C.VGPaint {
+	if c.paint == C.VG_INVALID_HANDLE {
+		c.paint = C.ColorPaint(C.uint(c.Red), C.uint(c.Green), C.uint(c.Blue), C.VGfloat(c.Alpha))
+	}
+	return c.paint
+}
+
+// Destroy frees the color's paint
+func (c *ColorHandle) Destroy() {
+	if c.paint != C.VG_INVALID_HANDLE {
+		C.vgDestroyPaint(c.paint)
+		c.paint = C.VG_INVALID_HANDLE
+	}
+}
+
+// FillColorHandle sets the fill color to a resolved color, with no lookup or new paint
+func FillColorHandle(c *ColorHandle) {
+	C.FillPaint(c.getpaint())
+}
+
+// StrokeColorHandle sets the stroke color to a resolved color, with no lookup or new paint
+func StrokeColorHandle(c *ColorHandle) {
+	C.StrokePaint(c.getpaint())
+}
+
 // Start begins a picture
 func Start(w, h int, color ...uint8) {
 	C.Start(C.int(w), C.int(h))
@@ -365,6 +290,153 @@ func SaveEnd(filename string) {
 	C.SaveEnd(s)
 }
 
+// SaveEndPNG ends the picture, saving the window as a PNG file
+func SaveEndPNG(filename string) {
+	s := C.CString(filename)
+	defer C.free(unsafe.Pointer(s))
+	C.SaveEndPNG(s)
+}
+
+// CaptureInto reads the w x h rectangle at (x,y) of the window into pix, as red, green, blue,
+// alpha bytes, w*4 bytes per row, top row first if topdown, otherwise bottom row first.
+// It reports false if pix is too small, or the rectangle is not within the window.
+func CaptureInto(pix []byte, x, y, w, h int, topdown bool) bool {
+	flags := C.int(0)
+	if topdown {
+		flags = C.CAPTURE_TOPDOWN
+	}
+	return captureinto(pix, x, y, w, h, flags)
+}
+
+// captureinto reads a rectangle of the window into pix with CAPTURE_ flags
+func captureinto(pix []byte, x, y, w, h int, flags C.int) bool {
+	if w <= 0 || h <= 0 || len(pix) < w*h*4 {
+		return false
+	}
+	return C.CaptureRectInto((*C.VGubyte)(unsafe.Pointer(&pix[0])), C.int(w*4), C.int(x), C.int(y), C.int(w), C.int(h), flags) == 0
+}
+
+// Recorder writes frames to a file or pipe on a background thread
+type Recorder struct {
+	r *C.Recorder
+}
+
+// NewRecorder starts recording the w x h rectangle at (x,y) of the window, as raw frames like SaveEnd's,
+// to a file, "-" for standard output, or "|command" to pipe to a command. Up to nbuffers frames
+// wait for the writer; when it falls behind, frames are dropped and counted.
+func NewRecorder(name string, x, y, w, h, nbuffers int, topdown bool) *Recorder {
+	return newRecorder(name, x, y, w, h, nbuffers, topdown, 0)
+}
+
+// NewDeltaRecorder starts recording like NewRecorder, as a delta compressed
+// recording: a keyframe, then the rows changed from one frame to the next.
+// The deltaexport client turns a recording back into frames or PNG files.
+func NewDeltaRecorder(name string, x, y, w, h, nbuffers int, topdown bool) *Recorder {
+	return newRecorder(name, x, y, w, h, nbuffers, topdown, C.RECORD_DELTA)
+}
+
+// newRecorder opens a recorder with RECORD_ flags
+func newRecorder(name string, x, y, w, h, nbuffers int, topdown bool, flags C.int) *Recorder {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	if topdown {
+		flags |= C.CAPTURE_TOPDOWN
+	}
+	r := C.RecordOpen(s, C.int(x), C.int(y), C.int(w), C.int(h), C.int(nbuffers), flags)
+	if r == nil {
+		return nil
+	}
+	return &Recorder{r}
+}
+
+// Frame queues the current frame for writing
+func (r *Recorder) Frame() {
+	C.RecordFrame(r.r)
+}
+
+// End records the frame, and ends the picture
+func (r *Recorder) End() {
+	C.RecordEnd(r.r)
+}
+
+// Stats returns the number of frames written and dropped so far
+func (r *Recorder) Stats() (frames, dropped uint64) {
+	var f, d C.ulong
+	C.RecordStats(r.r, &f, &d)
+	return uint64(f), uint64(d)
+}
+
+// Close writes the queued frames and closes the output, reporting false on a write error
+func (r *Recorder) Close() bool {
+	ok := C.RecordClose(r.r) == 0
+	r.r = nil
+	return ok
+}
+
+// FrameShare publishes frames in shared memory, for other processes to read without copies
+type FrameShare struct {
+	s *C.FrameShare
+}
+
+// NewFrameShare creates the shared memory object name, to publish the w x h rectangle at (x,y)
+// of the window in, in a ring of nslots frames. Readers attach with ShareAttach from C,
+// or the sharewatch client.
+func NewFrameShare(name string, x, y, w, h, nslots int, topdown bool) *FrameShare {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	flags := C.int(0)
+	if topdown {
+		flags = C.CAPTURE_TOPDOWN
+	}
+	fs := C.ShareOpen(s, C.int(x), C.int(y), C.int(w), C.int(h), C.int(nslots), flags)
+	if fs == nil {
+		return nil
+	}
+	return &FrameShare{fs}
+}
+
+// Frame publishes the current frame, reporting false if the rectangle is not within the window
+func (f *FrameShare) Frame() bool {
+	return C.ShareFrame(f.s) == 0
+}
+
+// End publishes the frame, and ends the picture
+func (f *FrameShare) End() {
+	C.ShareEnd(f.s)
+}
+
+// Close removes the shared memory object; readers keep what they have mapped
+func (f *FrameShare) Close() {
+	C.ShareClose(f.s)
+	f.s = nil
+}
+
+// CaptureImage reads the w x h rectangle at (x,y) of the window as an image, or nil
+func CaptureImage(x, y, w, h int) *image.NRGBA {
+	if w <= 0 || h <= 0 {
+		return nil
+	}
+	im := image.NewNRGBA(image.Rect(0, 0, w, h))
+	if !CaptureInto(im.Pix, x, y, w, h, true) {
+		return nil
+	}
+	return im
+}
+
+// CaptureDisplayImage reads the w x h rectangle at (x,y) of the window as it is shown on the
+// display, with any video or other layers, from a dispmanx snapshot; or nil. It is the frame
+// last shown, so call it after End.
+func CaptureDisplayImage(x, y, w, h int) *image.NRGBA {
+	if w <= 0 || h <= 0 {
+		return nil
+	}
+	im := image.NewNRGBA(image.Rect(0, 0, w, h))
+	if !captureinto(im.Pix, x, y, w, h, C.CAPTURE_TOPDOWN|C.CAPTURE_DISPLAY) {
+		return nil
+	}
+	return im
+}
+
 // fakeimage makes a placeholder for a missing image
 func fakeimage(x, y VGfloat, w, h int, s string) {
 	fw := VGfloat(w)
@@ -380,30 +452,323 @@ func fakeimage(x, y VGfloat, w, h int, s string) {
 	TextMid(x+(fw/2), y+(fh/2), s, "sans", w/20)
 }
 
-// Img places an image object at (x,y)
-func Img(x, y VGfloat, im image.Image) {
+// rasters holds conversion buffers for reuse by Img and NewImage
+var rasters sync.Pool
+
+// getraster returns a buffer of n bytes, reusing an earlier one if it is large enough
+func getraster(n int) []byte {
+	if p, ok := rasters.Get().(*[]byte); ok && cap(*p) >= n {
+		return (*p)[:n]
+	}
+	return make([]byte, n)
+}
+
+// putraster returns a buffer for reuse
+func putraster(b []byte) {
+	rasters.Put(&b)
+}
+
+// toraster converts an image to red, green, blue, alpha rows in OpenVG (bottom row first)
+// order, returning the alpha mode of the result. Common image types are converted a row at
+// a time; others go through At.
+func toraster(im image.Image, data []byte) C.int {
 	bounds := im.Bounds()
-	minx := bounds.Min.X
-	maxx := bounds.Max.X
-	miny := bounds.Min.Y
-	maxy := bounds.Max.Y
-	data := make([]C.VGubyte, bounds.Dx()*bounds.Dy()*4)
+	minx, miny, maxy := bounds.Min.X, bounds.Min.Y, bounds.Max.Y
+	w, h := bounds.Dx(), bounds.Dy()
+	dst := (*C.VGubyte)(unsafe.Pointer(&data[0]))
+	switch m := im.(type) {
+	case *image.NRGBA: // same layout, only the row order differs
+		C.FlipRaster(dst, C.int(w*4), (*C.VGubyte)(unsafe.Pointer(&m.Pix[m.PixOffset(minx, miny)])), C.int(m.Stride), C.int(w*4), C.int(h))
+		return C.ALPHA_STRAIGHT
+	case *image.RGBA:
+		C.FlipRaster(dst, C.int(w*4), (*C.VGubyte)(unsafe.Pointer(&m.Pix[m.PixOffset(minx, miny)])), C.int(m.Stride), C.int(w*4), C.int(h))
+		return C.ALPHA_PREMULTIPLIED
+	case *image.Gray:
+		for y := 0; y < h; y++ {
+			C.GraytoRGBA((*C.VGubyte)(unsafe.Pointer(&data[(h-1-y)*w*4])), (*C.VGubyte)(unsafe.Pointer(&m.Pix[m.PixOffset(minx, miny+y)])), C.int(w))
+		}
+		return C.ALPHA_PREMULTIPLIED
+	case *image.YCbCr:
+		if m.SubsampleRatio == image.YCbCrSubsampleRatio420 && minx%2 == 0 && miny%2 == 0 {
+			C.I420toRGBA(dst, C.int(w*4), (*C.VGubyte)(unsafe.Pointer(&m.Y[m.YOffset(minx, miny)])),
+				(*C.VGubyte)(unsafe.Pointer(&m.Cb[m.COffset(minx, miny)])), (*C.VGubyte)(unsafe.Pointer(&m.Cr[m.COffset(minx, miny)])),
+				C.int(m.YStride), C.int(m.CStride), C.int(w), C.int(h), C.YUV_FULL)
+			return C.ALPHA_PREMULTIPLIED
+		}
+		n := 0
+		for y := maxy - 1; y >= miny; y-- {
+			for x := minx; x < bounds.Max.X; x++ {
+				ci := m.COffset(x, y)
+				data[n], data[n+1], data[n+2] = color.YCbCrToRGB(m.Y[m.YOffset(x, y)], m.Cb[ci], m.Cr[ci])
+				data[n+3] = 255
+				n += 4
+			}
+		}
+		return C.ALPHA_PREMULTIPLIED
+	}
 	n := 0
 	var r, g, b, a uint32
 	for yp := miny; yp < maxy; yp++ {
-		for xp := minx; xp < maxx; xp++ {
-			r, g, b, a = im.At(xp, (maxy-1)-yp).RGBA() // OpenVG has origin at lower left, y increasing up
-			data[n] = C.VGubyte(r >> 8)
-			n++
-			data[n] = C.VGubyte(g >> 8)
-			n++
-			data[n] = C.VGubyte(b >> 8)
-			n++
-			data[n] = C.VGubyte(a >> 8)
-			n++
+		for xp := minx; xp < bounds.Max.X; xp++ {
+			r, g, b, a = im.At(xp, (maxy-1)-(yp-miny)).RGBA() // OpenVG has origin at lower left, y increasing up
+			data[n] = byte(r >> 8)
+			data[n+1] = byte(g >> 8)
+			data[n+2] = byte(b >> 8)
+			data[n+3] = byte(a >> 8)
+			n += 4
 		}
 	}
-	C.makeimage(C.VGfloat(x), C.VGfloat(y), C.int(bounds.Dx()), C.int(bounds.Dy()), &data[0])
+	return C.ALPHA_PREMULTIPLIED // RGBA returns premultiplied values
+}
+
+// Img places an image object at (x,y)
+func Img(x, y VGfloat, im image.Image) {
+	bounds := im.Bounds()
+	if bounds.Empty() {
+		return
+	}
+	data := getraster(bounds.Dx() * bounds.Dy() * 4)
+	alpha := toraster(im, data)
+	C.makeimageAlpha(C.VGfloat(x), C.VGfloat(y), C.int(bounds.Dx()), C.int(bounds.Dy()), (*C.VGubyte)(unsafe.Pointer(&data[0])), alpha)
+	putraster(data)
+}
+
+// ImageHandle is an image converted and uploaded once, to be drawn many times
+type ImageHandle struct {
+	img  C.VGImage
+	w, h int
+}
+
+// NewImage converts and uploads an image object
+func NewImage(im image.Image) *ImageHandle {
+	bounds := im.Bounds()
+	if bounds.Empty() {
+		return nil
+	}
+	w, h := bounds.Dx(), bounds.Dy()
+	data := getraster(w * h * 4)
+	alpha := toraster(im, data)
+	img := C.createImage((*C.VGubyte)(unsafe.Pointer(&data[0])), C.int(w), C.int(h), C.int(w*4), alpha)
+	putraster(data)
+	if img == C.VG_INVALID_HANDLE {
+		return nil
+	}
+	return &ImageHandle{img, w, h}
+}
+
+// Size returns the image dimensions
+func (i *ImageHandle) Size() (int, int) {
+	return i.w, i.h
+}
+
+// Draw places the image at (x,y)
+func (i *ImageHandle) Draw(x, y VGfloat) {
+	C.vgSetPixels(C.VGint(x), C.VGint(y), i.img, 0, 0, C.VGint(i.w), C.VGint(i.h))
+}
+
+// DrawScaled draws the image at (x,y) scaled to (w,h), blended and transformed like shapes
+func (i *ImageHandle) DrawScaled(x, y, w, h VGfloat) {
+	C.DrawImageScaled(i.img, C.VGfloat(x), C.VGfloat(y), C.VGfloat(w), C.VGfloat(h))
+}
+
+// Destroy frees the image
+func (i *ImageHandle) Destroy() {
+	C.vgDestroyImage(i.img)
+	i.img = C.VG_INVALID_HANDLE
+}
+
+// Thumbnail draws the named JPEG image at (x,y) scaled to (w,h), from its
+// embedded EXIF thumbnail when that is large enough
+func Thumbnail(x, y VGfloat, w, h int, name string) {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	C.Thumbnail(C.VGfloat(x), C.VGfloat(y), C.int(w), C.int(h), s)
+}
+
+// RawImage places the named raw image file (see jpeg2raw) at (x,y)
+func RawImage(x, y VGfloat, name string) {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	C.RawImage(C.VGfloat(x), C.VGfloat(y), s)
+}
+
+// StreamImage is a persistent image for rasters that change every frame,
+// such as camera frames or live charts.
+type StreamImage struct {
+	si *C.StreamImage
+}
+
+// NewStreamImage allocates a w x h streaming image; with two buffers
+// updates go to the image that is not being drawn.
+func NewStreamImage(w, h, buffers int) *StreamImage {
+	si := C.StreamImageCreate(C.int(w), C.int(h), C.int(buffers))
+	if si == nil {
+		return nil
+	}
+	return &StreamImage{si}
+}
+
+// Update copies a whole raster of red, green, blue, alpha bytes (bottom row first,
+// stride bytes per row) to the image
+func (s *StreamImage) Update(data []byte, stride int) {
+	if len(data) > 0 {
+		C.StreamImageUpdate(s.si, (*C.VGubyte)(unsafe.Pointer(&data[0])), C.int(stride))
+	}
+}
+
+// UpdateRect copies the changed region (x, y, w, h) of a whole raster to the image
+func (s *StreamImage) UpdateRect(data []byte, stride, x, y, w, h int) {
+	if len(data) > 0 {
+		C.StreamImageUpdateRect(s.si, (*C.VGubyte)(unsafe.Pointer(&data[0])), C.int(stride), C.int(x), C.int(y), C.int(w), C.int(h))
+	}
+}
+
+// Draw places the most recently updated image at (x,y)
+func (s *StreamImage) Draw(x, y VGfloat) {
+	C.StreamImageDraw(s.si, C.VGfloat(x), C.VGfloat(y))
+}
+
+// Destroy frees the image
+func (s *StreamImage) Destroy() {
+	C.StreamImageDestroy(s.si)
+	s.si = nil
+}
+
+// MipImage is an image with copies at half size, quarter size and so on,
+// for drawing it scaled down
+type MipImage struct {
+	m *C.MipImage
+}
+
+// NewMipImage makes a mip image from the named JPEG file
+func NewMipImage(name string) *MipImage {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	m := C.MipImageFromJpeg(s)
+	if m == nil {
+		return nil
+	}
+	return &MipImage{m}
+}
+
+// Size returns the full size dimensions
+func (m *MipImage) Size() (int, int) {
+	var w, h C.int
+	C.MipImageSize(m.m, &w, &h)
+	return int(w), int(h)
+}
+
+// Draw draws the image at (x,y) scaled to (w,h)
+func (m *MipImage) Draw(x, y, w, h VGfloat) {
+	C.MipImageDraw(m.m, C.VGfloat(x), C.VGfloat(y), C.VGfloat(w), C.VGfloat(h))
+}
+
+// Destroy frees the image
+func (m *MipImage) Destroy() {
+	C.MipImageDestroy(m.m)
+	m.m = nil
+}
+
+// TiledImage displays a JPEG picture too large for one image, decoding
+// only the tiles in view
+type TiledImage struct {
+	ti *C.TiledImage
+}
+
+// OpenTiledImage prepares the named JPEG file for display in tiles of the given size
+// (0 for the default), keeping up to budget bytes of decoded tiles (0 for no limit)
+func OpenTiledImage(name string, tilesize, budget int) *TiledImage {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	ti := C.TiledImageOpen(s, C.int(tilesize), C.size_t(budget))
+	if ti == nil {
+		return nil
+	}
+	return &TiledImage{ti}
+}
+
+// Size returns the dimensions of the picture
+func (t *TiledImage) Size() (int, int) {
+	var w, h C.int
+	C.TiledImageSize(t.ti, &w, &h)
+	return int(w), int(h)
+}
+
+// Draw fills the viewport (vx, vy, vw, vh) with the picture zoomed by zoom,
+// centered on picture point (cx, cy)
+func (t *TiledImage) Draw(cx, cy, zoom, vx, vy, vw, vh VGfloat) {
+	C.TiledImageDraw(t.ti, C.VGfloat(cx), C.VGfloat(cy), C.VGfloat(zoom), C.VGfloat(vx), C.VGfloat(vy), C.VGfloat(vw), C.VGfloat(vh))
+}
+
+// Close frees the tiles
+func (t *TiledImage) Close() {
+	C.TiledImageClose(t.ti)
+	t.ti = nil
+}
+
+// Atlas packs many small images into one, and draws them as sprites
+type Atlas struct {
+	a *C.Atlas
+}
+
+// NewAtlas allocates a w x h atlas for images that are not premultiplied
+func NewAtlas(w, h int) *Atlas {
+	a := C.AtlasCreate(C.int(w), C.int(h), C.ALPHA_PREMULTIPLY)
+	if a == nil {
+		return nil
+	}
+	return &Atlas{a}
+}
+
+// Add packs an image into the atlas, returning its sprite number, or -1 if it is full
+func (a *Atlas) Add(im image.Image) int {
+	bounds := im.Bounds()
+	w, h := bounds.Dx(), bounds.Dy()
+	if w == 0 || h == 0 {
+		return -1
+	}
+	data := make([]byte, w*h*4)
+	n := 0
+	for y := bounds.Max.Y - 1; y >= bounds.Min.Y; y-- {
+		for x := bounds.Min.X; x < bounds.Max.X; x++ {
+			c := color.NRGBAModel.Convert(im.At(x, y)).(color.NRGBA)
+			data[n], data[n+1], data[n+2], data[n+3] = c.R, c.G, c.B, c.A
+			n += 4
+		}
+	}
+	return int(C.AtlasAdd(a.a, (*C.VGubyte)(unsafe.Pointer(&data[0])), C.int(w), C.int(h), C.int(w*4)))
+}
+
+// AddJpeg packs the named JPEG file into the atlas, returning its sprite number, or -1
+func (a *Atlas) AddJpeg(name string) int {
+	s := C.CString(name)
+	defer C.free(unsafe.Pointer(s))
+	return int(C.AtlasAddJpeg(a.a, s))
+}
+
+// Draw draws a sprite at (x,y)
+func (a *Atlas) Draw(sprite int, x, y VGfloat) {
+	C.AtlasDraw(a.a, C.int(sprite), C.VGfloat(x), C.VGfloat(y))
+}
+
+// DrawList draws sprite[i] at (x[i], y[i]) in one call
+func (a *Atlas) DrawList(sprite []int32, x, y []VGfloat) {
+	n := len(sprite)
+	if len(x) < n {
+		n = len(x)
+	}
+	if len(y) < n {
+		n = len(y)
+	}
+	if n > 0 {
+		C.AtlasDrawList(a.a, (*C.int)(unsafe.Pointer(&sprite[0])), (*C.VGfloat)(&x[0]), (*C.VGfloat)(&y[0]), C.int(n))
+	}
+}
+
+// Destroy frees the atlas
+func (a *Atlas) Destroy() {
+	C.AtlasDestroy(a.a)
+	a.a = nil
 }
 
 // Image places the named image at (x,y) with dimensions (w,h)
@@ -426,6 +791,57 @@ func Image(x, y VGfloat, w, h int, s string) {
 	Img(x, y, img)
 }
 
+// Slideshow prefetches a sequence of JPEG images, so that showing
+// the next one does not wait for it to be decoded.
+type Slideshow struct {
+	ss *C.Slideshow
+}
+
+// NewSlideshow prepares the named JPEG files for display in order, keeping up to
+// ahead images after the current one decoded and uploaded, within budget bytes (0 for no limit).
+func NewSlideshow(files []string, ahead, budget int) *Slideshow {
+	if len(files) == 0 {
+		return nil
+	}
+	paths := make([]*C.char, len(files))
+	for i, f := range files {
+		paths[i] = C.CString(f)
+	}
+	ss := C.SlideshowOpen(&paths[0], C.int(len(paths)), C.int(ahead), C.size_t(budget))
+	for _, p := range paths {
+		C.free(unsafe.Pointer(p))
+	}
+	if ss == nil {
+		return nil
+	}
+	return &Slideshow{ss}
+}
+
+// Size makes image i current, returning its dimensions
+func (s *Slideshow) Size(i int) (int, int) {
+	var w, h C.int
+	if C.SlideshowImage(s.ss, C.int(i), &w, &h) == C.VG_INVALID_HANDLE {
+		return 0, 0
+	}
+	return int(w), int(h)
+}
+
+// Show places image i at (x,y), making it current
+func (s *Slideshow) Show(i int, x, y VGfloat) {
+	C.SlideshowShow(s.ss, C.int(i), C.VGfloat(x), C.VGfloat(y))
+}
+
+// Prefetch uploads the images decoded ahead of the current one
+func (s *Slideshow) Prefetch() {
+	C.SlideshowPrefetch(s.ss)
+}
+
+// Close stops prefetching and frees the images
+func (s *Slideshow) Close() {
+	C.SlideshowClose(s.ss)
+	s.ss = nil
+}
+
 // Line draws a line between two points
 func Line(x1, y1, x2, y2 VGfloat) {
 	C.Line(C.VGfloat(x1), C.VGfloat(y1), C.VGfloat(x2), C.VGfloat(y2))
@@ -470,19 +886,13 @@ func Arc(x, y, w, h, sa, aext VGfloat) {
 	C.Arc(C.VGfloat(x), C.VGfloat(y), C.VGfloat(w), C.VGfloat(h), C.VGfloat(sa), C.VGfloat(aext))
 }
 
-// poly converts coordinate slices
+// poly passes coordinate slices to C as they are, since VGfloat is C.VGfloat
 func poly(x, y []VGfloat) (*C.VGfloat, *C.VGfloat, C.VGint) {
 	size := len(x)
-	if size != len(y) {
+	if size == 0 || size != len(y) {
 		return nil, nil, 0
 	}
-	px := make([]C.VGfloat, size)
-	py := make([]C.VGfloat, size)
-	for i := 0; i < size; i++ {
-		px[i] = C.VGfloat(x[i])
-		py[i] = C.VGfloat(y[i])
-	}
-	return &px[0], &py[0], C.VGint(size)
+	return (*C.VGfloat)(&x[0]), (*C.VGfloat)(&y[0]), C.VGint(size)
 }
 
 // Polygon draws a polygon with coordinate in x,y
@@ -524,32 +934,95 @@ func ClipEnd() {
 	C.ClipEnd()
 }
 
+// FrameTimes are the times of recent frames, in ms
+type FrameTimes struct {
+	Count     int                  // frames timed
+	Mean, Max float64              // ms
+	Hist      [C.FRAME_BUCKETS]int // frames in each 2 ms; the last holds all longer times
+}
+
+// FrameStats are frame counts since the start, and the times of recent frames
+type FrameStats struct {
+	Frames, Janks       uint64  // janks are frames more than 1.5 periods after the last
+	Period              float64 // ms expected between frames
+	Count, RecentJanks  int     // frames timed, and the janks among them
+	CPU, Swap, Interval FrameTimes
+}
+
+// FrameRate paces End to fps frames a second, sleeping until the next frame is due; 0 stops pacing
+func FrameRate(fps float64) {
+	C.FrameRate(C.VGfloat(fps))
+}
+
+// FrameVsync paces End to every nth vertical sync of the display; 0 stops.
+// It reports false if the display has no vsync callback.
+func FrameVsync(n int) bool {
+	return C.FrameVsync(C.int(n)) == 0
+}
+
+// FrameStatsReset starts the frame statistics again
+func FrameStatsReset() {
+	C.FrameStatsReset()
+}
+
+// FrameStatsRead returns the frame statistics; it may be called from any goroutine
+func FrameStatsRead() FrameStats {
+	var cs C.FrameStats
+	C.FrameStatsRead(&cs)
+	times := func(t *C.FrameTimes) FrameTimes {
+		ft := FrameTimes{Count: int(t.count), Mean: float64(t.mean), Max: float64(t.max)}
+		for i := range ft.Hist {
+			ft.Hist[i] = int(t.hist[i])
+		}
+		return ft
+	}
+	return FrameStats{
+		Frames:      uint64(cs.frames),
+		Janks:       uint64(cs.janks),
+		Period:      float64(cs.period),
+		Count:       int(cs.count),
+		RecentJanks: int(cs.recentjanks),
+		CPU:         times(&cs.cpu),
+		Swap:        times(&cs.swap),
+		Interval:    times(&cs.interval),
+	}
+}
+
+// InvalidateRect marks a rectangle of the window, in window coordinates, to be redrawn by the next StartDamaged
+func InvalidateRect(x, y, w, h VGfloat) {
+	C.InvalidateRect(C.VGfloat(x), C.VGfloat(y), C.VGfloat(w), C.VGfloat(h))
+}
+
+// InvalidateWindow marks the whole window to be redrawn by the next StartDamaged
+func InvalidateWindow() {
+	C.InvalidateWindow()
+}
+
+// StartDamaged begins the picture as Start, but clears and draws only within the invalidated
+// rectangles until End; the rest of the window keeps the last frame. It returns the number of
+// rectangles: with none, nothing changed, and no picture is begun, so skip drawing and End.
+func StartDamaged(w, h int) int {
+	return int(C.StartDamaged(C.int(w), C.int(h)))
+}
+
 // Text draws text whose aligment begins (x,y)
 func Text(x, y VGfloat, s string, font string, size int) {
-	t := C.CString(s)
-	C.Text(C.VGfloat(x), C.VGfloat(y), t, selectfont(font), C.int(size))
-	C.free(unsafe.Pointer(t))
+	C.gotext(C.VGfloat(x), C.VGfloat(y), s, selectfont(font), C.int(size))
 }
 
 // TextMid draws text centered at (x,y)
 func TextMid(x, y VGfloat, s string, font string, size int) {
-	t := C.CString(s)
-	C.TextMid(C.VGfloat(x), C.VGfloat(y), t, selectfont(font), C.int(size))
-	C.free(unsafe.Pointer(t))
+	C.gotextmid(C.VGfloat(x), C.VGfloat(y), s, selectfont(font), C.int(size))
 }
 
 // TextEnd draws text end-aligned at (x,y)
 func TextEnd(x, y VGfloat, s string, font string, size int) {
-	t := C.CString(s)
-	C.TextEnd(C.VGfloat(x), C.VGfloat(y), t, selectfont(font), C.int(size))
-	C.free(unsafe.Pointer(t))
+	C.gotextend(C.VGfloat(x), C.VGfloat(y), s, selectfont(font), C.int(size))
 }
 
 // TextWidth returns the length of text at a specified font and size
 func TextWidth(s string, font string, size int) VGfloat {
-	t := C.CString(s)
-	defer C.free(unsafe.Pointer(t))
-	return VGfloat(C.TextWidth(t, selectfont(font), C.int(size)))
+	return VGfloat(C.gotextwidth(s, selectfont(font), C.int(size)))
 }
 
 // TextHeight returns a font's height (ascent)
@@ -0,0 +1,274 @@
+//
+// pixconv: pixel format conversion for image uploads and readback
+//
+// Rows are converted 16 bytes or more at a time with NEON on ARM
+// (build with -mfpu=neon) or SSE2/SSSE3 on x86; the scalar code
+// handles what remains and gives identical results.
+//
+#include <stdlib.h>
+#include <string.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIX_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PIX_SSE2
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define PIX_SSSE3
+#endif
+#endif
+
+#if defined(PIX_SSSE3)
+// expand3 expands 4 three-byte pixels to red, green, blue, alpha using a byte shuffle
+static int expand3(VGubyte * dst, const VGubyte * src, int n, __m128i order) {
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+	int x;
+	for (x = 0; x + 6 <= n; x += 4) {			   // 16 byte loads of 12 byte groups
+		__m128i p = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 3)), order);
+		_mm_storeu_si128((__m128i *) (dst + x * 4), _mm_or_si128(p, alpha));
+	}
+	return x;
+}
+#endif
+
+// RGBtoRGBA expands n pixels of red, green, blue bytes to red, green, blue, alpha
+void RGBtoRGBA(VGubyte * dst, const VGubyte * src, int n) {
+	int x = 0;
+#if defined(PIX_NEON)
+	uint8x16x3_t s;
+	uint8x16x4_t d;
+	d.val[3] = vdupq_n_u8(255);
+	for (; x + 16 <= n; x += 16) {
+		s = vld3q_u8(src + x * 3);
+		d.val[0] = s.val[0];
+		d.val[1] = s.val[1];
+		d.val[2] = s.val[2];
+		vst4q_u8(dst + x * 4, d);
+	}
+#elif defined(PIX_SSSE3)
+	x = expand3(dst, src, n, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+#endif
+	for (; x < n; x++) {
+		dst[x * 4 + 0] = src[x * 3 + 0];
+		dst[x * 4 + 1] = src[x * 3 + 1];
+		dst[x * 4 + 2] = src[x * 3 + 2];
+		dst[x * 4 + 3] = 255;
+	}
+}
+
+// BGRtoRGBA expands n pixels of blue, green, red bytes to red, green, blue, alpha
+void BGRtoRGBA(VGubyte * dst, const VGubyte * src, int n) {
+	int x = 0;
+#if defined(PIX_NEON)
+	uint8x16x3_t s;
+	uint8x16x4_t d;
+	d.val[3] = vdupq_n_u8(255);
+	for (; x + 16 <= n; x += 16) {
+		s = vld3q_u8(src + x * 3);
+		d.val[0] = s.val[2];
+		d.val[1] = s.val[1];
+		d.val[2] = s.val[0];
+		vst4q_u8(dst + x * 4, d);
+	}
+#elif defined(PIX_SSSE3)
+	x = expand3(dst, src, n, _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1));
+#endif
+	for (; x < n; x++) {
+		dst[x * 4 + 0] = src[x * 3 + 2];
+		dst[x * 4 + 1] = src[x * 3 + 1];
+		dst[x * 4 + 2] = src[x * 3 + 0];
+		dst[x * 4 + 3] = 255;
+	}
+}
+
+// GraytoRGBA expands n gray bytes to red, green, blue, alpha
+void GraytoRGBA(VGubyte * dst, const VGubyte * src, int n) {
+	int x = 0;
+#if defined(PIX_NEON)
+	uint8x16x4_t d;
+	d.val[3] = vdupq_n_u8(255);
+	for (; x + 16 <= n; x += 16) {
+		d.val[0] = d.val[1] = d.val[2] = vld1q_u8(src + x);
+		vst4q_u8(dst + x * 4, d);
+	}
+#elif defined(PIX_SSE2)
+	const __m128i alpha = _mm_set1_epi8(-1);
+	__m128i g, gg, ga;
+	for (; x + 16 <= n; x += 16) {
+		g = _mm_loadu_si128((const __m128i *)(src + x));
+		gg = _mm_unpacklo_epi8(g, g);
+		ga = _mm_unpacklo_epi8(g, alpha);
+		_mm_storeu_si128((__m128i *) (dst + x * 4), _mm_unpacklo_epi16(gg, ga));
+		_mm_storeu_si128((__m128i *) (dst + x * 4 + 16), _mm_unpackhi_epi16(gg, ga));
+		gg = _mm_unpackhi_epi8(g, g);
+		ga = _mm_unpackhi_epi8(g, alpha);
+		_mm_storeu_si128((__m128i *) (dst + x * 4 + 32), _mm_unpacklo_epi16(gg, ga));
+		_mm_storeu_si128((__m128i *) (dst + x * 4 + 48), _mm_unpackhi_epi16(gg, ga));
+	}
+#endif
+	for (; x < n; x++) {
+		dst[x * 4 + 0] = dst[x * 4 + 1] = dst[x * 4 + 2] = src[x];
+		dst[x * 4 + 3] = 255;
+	}
+}
+
+// SwizzleRGBA reverses the byte order of n pixels, converting between the
+// VG_sRGBA_8888 and VG_sABGR_8888 memory layouts; dst may be src.
+void SwizzleRGBA(VGubyte * dst, const VGubyte * src, int n) {
+	int x = 0;
+	VGubyte t;
+#if defined(PIX_NEON)
+	for (; x + 4 <= n; x += 4) {
+		vst1q_u8(dst + x * 4, vrev32q_u8(vld1q_u8(src + x * 4)));
+	}
+#elif defined(PIX_SSSE3)
+	const __m128i order = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	for (; x + 4 <= n; x += 4) {
+		_mm_storeu_si128((__m128i *) (dst + x * 4),
+				 _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 4)), order));
+	}
+#elif defined(PIX_SSE2)
+	__m128i p, q;
+	for (; x + 4 <= n; x += 4) {
+		p = _mm_loadu_si128((const __m128i *)(src + x * 4));
+		q = _mm_or_si128(_mm_srli_epi16(p, 8), _mm_slli_epi16(p, 8));	// swap bytes in halves
+		q = _mm_shufflehi_epi16(_mm_shufflelo_epi16(q, 0xb1), 0xb1);	// swap halves
+		_mm_storeu_si128((__m128i *) (dst + x * 4), q);
+	}
+#endif
+	for (; x < n; x++) {
+		t = src[x * 4 + 0];
+		dst[x * 4 + 0] = src[x * 4 + 3];
+		dst[x * 4 + 3] = t;
+		t = src[x * 4 + 1];
+		dst[x * 4 + 1] = src[x * 4 + 2];
+		dst[x * 4 + 2] = t;
+	}
+}
+
+// mul255 returns c*a/255, rounded
+static inline VGubyte mul255(unsigned int c, unsigned int a) {
+	unsigned int t = c * a + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+// PremultiplyRGBA multiplies the red, green and blue of n pixels by their alpha; dst may be src.
+void PremultiplyRGBA(VGubyte * dst, const VGubyte * src, int n) {
+	int x = 0;
+#if defined(PIX_NEON)
+	uint8x16x4_t p;
+	uint16x8_t lo, hi;
+	int c;
+	for (; x + 16 <= n; x += 16) {
+		p = vld4q_u8(src + x * 4);
+		for (c = 0; c < 3; c++) {
+			lo = vmull_u8(vget_low_u8(p.val[c]), vget_low_u8(p.val[3]));
+			hi = vmull_u8(vget_high_u8(p.val[c]), vget_high_u8(p.val[3]));
+			p.val[c] = vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)), vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+		}
+		vst4q_u8(dst + x * 4, p);
+	}
+#elif defined(PIX_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(128);
+	const __m128i rgb = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+	const __m128i opaque = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+	__m128i p, h[2], a, t;
+	int i;
+	for (; x + 4 <= n; x += 4) {
+		p = _mm_loadu_si128((const __m128i *)(src + x * 4));
+		h[0] = _mm_unpacklo_epi8(p, zero);
+		h[1] = _mm_unpackhi_epi8(p, zero);
+		for (i = 0; i < 2; i++) {
+			a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(h[i], 0xff), 0xff);
+			a = _mm_or_si128(_mm_and_si128(a, rgb), opaque);	// alpha times 255 keeps alpha
+			t = _mm_add_epi16(_mm_mullo_epi16(h[i], a), round);
+			h[i] = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+		}
+		_mm_storeu_si128((__m128i *) (dst + x * 4), _mm_packus_epi16(h[0], h[1]));
+	}
+#endif
+	for (; x < n; x++) {
+		dst[x * 4 + 0] = mul255(src[x * 4 + 0], src[x * 4 + 3]);
+		dst[x * 4 + 1] = mul255(src[x * 4 + 1], src[x * 4 + 3]);
+		dst[x * 4 + 2] = mul255(src[x * 4 + 2], src[x * 4 + 3]);
+		dst[x * 4 + 3] = src[x * 4 + 3];
+	}
+}
+
+// FlipRaster copies h rows of rowbytes each, reversing their order, between rasters
+// with the given strides; dst may be src, when the strides are the same.
+void FlipRaster(VGubyte * dst, int dststride, const VGubyte * src, int srcstride, int rowbytes, int h) {
+	VGubyte tmp[1024];
+	VGubyte *top, *bottom;
+	int y, off, n;
+
+	if (dst != src) {
+		for (y = 0; y < h; y++) {
+			memcpy(dst + (h - 1 - y) * dststride, src + y * srcstride, rowbytes);
+		}
+		return;
+	}
+	for (y = 0; y < h / 2; y++) {
+		top = dst + y * dststride;
+		bottom = dst + (h - 1 - y) * dststride;
+		for (off = 0; off < rowbytes; off += n) {
+			n = rowbytes - off < (int)sizeof(tmp) ? rowbytes - off : (int)sizeof(tmp);
+			memcpy(tmp, top + off, n);
+			memcpy(top + off, bottom + off, n);
+			memcpy(bottom + off, tmp, n);
+		}
+	}
+}
+
+// HalveRGBA box filters a w x h raster to (w+1)/2 x (h+1)/2, averaging each 2 x 2 block;
+// an odd last row or column is averaged with itself.
+void HalveRGBA(VGubyte * dst, int dststride, const VGubyte * src, int srcstride, int w, int h) {
+	const VGubyte *r0, *r1;
+	VGubyte *d;
+	int dw = (w + 1) / 2, dh = (h + 1) / 2;
+	int x, y, c, x1;
+
+	for (y = 0; y < dh; y++) {
+		r0 = src + 2 * y * srcstride;
+		r1 = 2 * y + 1 < h ? r0 + srcstride : r0;
+		d = dst + y * dststride;
+		x = 0;
+#if defined(PIX_NEON)
+		uint16x8_t lo, hi;
+		for (; x + 2 <= w / 2; x += 2) {	   // 4 source pixels to 2
+			uint8x16_t a = vld1q_u8(r0 + x * 8), b = vld1q_u8(r1 + x * 8);
+			lo = vaddl_u8(vget_low_u8(a), vget_low_u8(b));
+			hi = vaddl_u8(vget_high_u8(a), vget_high_u8(b));
+			vst1_u8(d + x * 4, vrshrn_n_u16(vcombine_u16(vadd_u16(vget_low_u16(lo), vget_high_u16(lo)),
+							      vadd_u16(vget_low_u16(hi), vget_high_u16(hi))), 2));
+		}
+#elif defined(PIX_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i two = _mm_set1_epi16(2);
+		__m128i a, b, lo, hi;
+		for (; x + 2 <= w / 2; x += 2) {
+			a = _mm_loadu_si128((const __m128i *)(r0 + x * 8));
+			b = _mm_loadu_si128((const __m128i *)(r1 + x * 8));
+			lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+			lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+			hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+			lo = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+			_mm_storel_epi64((__m128i *) (d + x * 4), _mm_packus_epi16(lo, lo));
+		}
+#endif
+		for (; x < dw; x++) {
+			x1 = 2 * x + 1 < w ? 2 * x + 1 : 2 * x;
+			for (c = 0; c < 4; c++) {
+				d[x * 4 + c] = (r0[x * 8 + c] + r0[x1 * 4 + c] + r1[x * 8 + c] + r1[x1 * 4 + c] + 2) >> 2;
+			}
+		}
+	}
+}
@@ -0,0 +1,269 @@
+//
+// png: screenshots as PNG files
+//
+// Rows are filtered and emitted top row first straight from OpenVG's
+// bottom-up raster, so there is no flipped copy. Large frames are cut
+// into bands of rows, deflated by one thread each; every band but the
+// last ends on a byte boundary with a sync flush, so the pieces join
+// into one zlib stream, whose checksum is combined from the bands'.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+#define PNG_LEVEL	Z_BEST_SPEED
+#define PNG_MAXBANDS	8
+#define PNG_BANDBYTES	(256*1024)			   // smallest band worth a thread
+#define PNG_WINDOW	32768				   // deflate window, primed from the previous band
+
+typedef struct {
+	const VGubyte *data;				   // the raster
+	int width;
+	int stride;					   // from one emitted row to the next, negative for bottom-up
+	VGubyte *filtered;				   // all filtered rows
+	size_t rowbytes;				   // filtered row, with its filter byte
+	int row0, rows;					   // band of emitted rows
+	int last;
+	VGubyte *out;					   // deflated band
+	size_t outlen;
+	uLong adler;
+	int err;
+} Band;
+
+// filterrows filters rows r0..r0+n-1 with the Up filter, which suits screens and is cheap, into dst
+static void filterrows(const Band * b, VGubyte * dst, int r0, int n) {
+	const VGubyte *row, *prev;
+	size_t rowlen = (size_t) b->width * 4, i;
+	int r;
+
+	for (r = r0; r < r0 + n; r++, dst += b->rowbytes) {
+		row = b->data + (ptrdiff_t) r * b->stride;
+		if (r == 0) {
+			dst[0] = 0;			   // None; the first row has nothing above
+			memcpy(dst + 1, row, rowlen);
+			continue;
+		}
+		prev = row - b->stride;
+		dst[0] = 2;
+		for (i = 0; i < rowlen; i++) {
+			dst[i + 1] = row[i] - prev[i];
+		}
+	}
+}
+
+// deflateband filters and deflates a band, as raw deflate data primed with the end of the previous band.
+// The previous band is filtered by another thread, so the rows for the dictionary are filtered again here.
+static void *deflateband(void *arg) {
+	Band *b = (Band *) arg;
+	VGubyte *in = b->filtered + (size_t) b->row0 * b->rowbytes, *dict;
+	size_t inlen = (size_t) b->rows * b->rowbytes, dictlen;
+	z_stream z;
+	int k;
+
+	filterrows(b, in, b->row0, b->rows);
+	memset(&z, 0, sizeof(z));
+	if (deflateInit2(&z, PNG_LEVEL, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		b->err = 1;
+		return NULL;
+	}
+	if (b->row0 > 0) {
+		k = (PNG_WINDOW + b->rowbytes - 1) / b->rowbytes;	// rows to fill the window
+		k = k > b->row0 ? b->row0 : k;
+		dict = (VGubyte *) malloc((size_t) k * b->rowbytes);
+		if (dict == NULL) {
+			deflateEnd(&z);
+			b->err = 1;
+			return NULL;
+		}
+		filterrows(b, dict, b->row0 - k, k);
+		dictlen = (size_t) k * b->rowbytes;
+		dictlen = dictlen > PNG_WINDOW ? PNG_WINDOW : dictlen;
+		deflateSetDictionary(&z, dict + (size_t) k * b->rowbytes - dictlen, dictlen);
+		free(dict);
+	}
+	b->adler = adler32(adler32(0L, Z_NULL, 0), in, inlen);
+	b->outlen = deflateBound(&z, inlen) + 16;
+	b->out = (VGubyte *) malloc(b->outlen);
+	if (b->out == NULL) {
+		deflateEnd(&z);
+		b->err = 1;
+		return NULL;
+	}
+	z.next_in = in;
+	z.avail_in = inlen;
+	z.next_out = b->out;
+	z.avail_out = b->outlen;
+	if (deflate(&z, b->last ? Z_FINISH : Z_SYNC_FLUSH) != (b->last ? Z_STREAM_END : Z_OK) || z.avail_in != 0) {
+		b->err = 1;
+	}
+	b->outlen -= z.avail_out;
+	deflateEnd(&z);
+	return NULL;
+}
+
+// put32 stores a big-endian word
+static void put32(VGubyte * p, uLong v) {
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+// writechunk writes a PNG chunk of the concatenated pieces
+static int writechunk(FILE * fp, const char *type, const VGubyte ** piece, const size_t * len, int n) {
+	VGubyte word[4];
+	uLong crc, total = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		total += len[i];
+	}
+	put32(word, total);
+	if (fwrite(word, 4, 1, fp) != 1 || fwrite(type, 4, 1, fp) != 1) {
+		return -1;
+	}
+	crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef *)type, 4);
+	for (i = 0; i < n; i++) {
+		if (len[i] > 0 && fwrite(piece[i], len[i], 1, fp) != 1) {
+			return -1;
+		}
+		crc = crc32(crc, piece[i], len[i]);
+	}
+	put32(word, crc);
+	return fwrite(word, 4, 1, fp) == 1 ? 0 : -1;
+}
+
+// writepng writes a raster as a PNG file, returning 0, or -1 on failure
+static int writepng(FILE * fp, const VGubyte * data, int w, int h, int stride, int flags) {
+	static const VGubyte signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	static const VGubyte zhead[2] = { 0x78, 0x01 };	// deflate, 32K window, fastest
+	Band band[PNG_MAXBANDS];
+	pthread_t thread[PNG_MAXBANDS];
+	int started[PNG_MAXBANDS];
+	const VGubyte *piece[PNG_MAXBANDS + 2];
+	size_t len[PNG_MAXBANDS + 2], rowbytes;
+	VGubyte ihdr[13], ztail[4], *filtered;
+	uLong adler;
+	long ncpu;
+	int i, n, err = 0;
+
+	if (w <= 0 || h <= 0) {
+		return -1;
+	}
+	rowbytes = (size_t) w * 4 + 1;
+	filtered = (VGubyte *) malloc(rowbytes * h);
+	if (filtered == NULL) {
+		return -1;
+	}
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	n = (int)((rowbytes * h) / PNG_BANDBYTES);
+	n = n > ncpu ? (int)ncpu : n;
+	n = n > PNG_MAXBANDS ? PNG_MAXBANDS : n;
+	n = n > h ? h : n;
+	n = n < 1 ? 1 : n;
+	for (i = 0; i < n; i++) {
+		memset(&band[i], 0, sizeof(Band));
+		band[i].width = w;
+		if (flags & CAPTURE_TOPDOWN) {
+			band[i].data = data;
+			band[i].stride = stride;
+		} else {				   // emit from the top, the last row in memory
+			band[i].data = data + (size_t) (h - 1) * stride;
+			band[i].stride = -stride;
+		}
+		band[i].filtered = filtered;
+		band[i].rowbytes = rowbytes;
+		band[i].row0 = (int)((long)h * i / n);
+		band[i].rows = (int)((long)h * (i + 1) / n) - band[i].row0;
+		band[i].last = i == n - 1;
+	}
+	for (i = 1; i < n; i++) {
+		started[i] = pthread_create(&thread[i], NULL, deflateband, &band[i]) == 0;
+		if (!started[i]) {
+			deflateband(&band[i]);
+		}
+	}
+	deflateband(&band[0]);
+	for (i = 1; i < n; i++) {
+		if (started[i]) {
+			pthread_join(thread[i], NULL);
+		}
+	}
+
+	adler = band[0].adler;
+	piece[0] = zhead;
+	len[0] = 2;
+	for (i = 0; i < n; i++) {
+		err |= band[i].err;
+		if (i > 0) {
+			adler = adler32_combine(adler, band[i].adler, (z_off_t) band[i].rows * rowbytes);
+		}
+		piece[i + 1] = band[i].out;
+		len[i + 1] = band[i].outlen;
+	}
+	put32(ztail, adler);
+	piece[n + 1] = ztail;
+	len[n + 1] = 4;
+
+	put32(ihdr, w);
+	put32(ihdr + 4, h);
+	ihdr[8] = 8;					   // bits per channel
+	ihdr[9] = 6;					   // RGBA
+	ihdr[10] = ihdr[11] = ihdr[12] = 0;		   // deflate, adaptive filters, not interlaced
+	if (!err) {
+		const VGubyte *hdr = ihdr;
+		size_t hdrlen = sizeof(ihdr);
+		err = fwrite(signature, sizeof(signature), 1, fp) != 1
+		    || writechunk(fp, "IHDR", &hdr, &hdrlen, 1) != 0
+		    || writechunk(fp, "IDAT", piece, len, n + 2) != 0 || writechunk(fp, "IEND", NULL, NULL, 0) != 0;
+	}
+	for (i = 0; i < n; i++) {
+		free(band[i].out);
+	}
+	free(filtered);
+	return err ? -1 : 0;
+}
+
+// WritePNG writes a w x h raster of red, green, blue, alpha values, stride bytes per row,
+// bottom row first (as read from OpenVG), or top row first with CAPTURE_TOPDOWN, as a PNG file.
+// Returns 0, or -1 on failure.
+int WritePNG(const char *filename, const VGubyte * data, int w, int h, int stride, int flags) {
+	FILE *fp = fopen(filename, "wb");
+	int err;
+
+	if (fp == NULL) {
+		return -1;
+	}
+	err = writepng(fp, data, w, h, stride, flags);
+	if (fclose(fp) != 0 || err != 0) {
+		unlink(filename);
+		return -1;
+	}
+	return 0;
+}
+
+// SaveEndPNG ends the picture, saving the window as a PNG file (standard output if the name is empty).
+// The frame is shown before it is encoded.
+void SaveEndPNG(const char *filename) {
+	const VGubyte *pixels;
+	int w, h;
+
+	pixels = CaptureWindow(0, &w, &h);
+	End();
+	if (pixels == NULL) {
+		return;
+	}
+	if (filename[0] == '\0') {
+		writepng(stdout, pixels, w, h, w * 4, 0);
+		fflush(stdout);
+	} else {
+		WritePNG(filename, pixels, w, h, w * 4, 0);
+	}
+}
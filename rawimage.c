@@ -0,0 +1,149 @@
+//
+// rawimage: pre-decoded image files
+//
+// A raw image file is a header followed by pixel rows already in the
+// VG format and row order used for upload, so loading one is an mmap
+// and a vgImageSubData from the mapping, with no decoding.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+#include "vgcheck.h"
+
+#define RAWIMAGE_MAGIC "VGRW"
+#define RAWIMAGE_VERSION 1
+#define RAWIMAGE_OFFSET 64				   // pixel rows start here, aligned for vector loads
+
+// RawHeader begins the file, in the byte order of the machine that wrote it
+typedef struct {
+	char magic[4];					   // "VGRW"
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t format;				   // VGImageFormat of the rows
+	uint32_t stride;				   // bytes from one row to the next
+	uint32_t offset;				   // of the first (bottom) row
+	uint32_t reserved;
+} RawHeader;
+
+// RawImageWrite writes a w x h raster in a 32 bit VG format (bottom row first, stride bytes per row)
+// to a raw image file, returning 0, or -1 on failure.
+int RawImageWrite(const char *filename, const VGubyte * data, int w, int h, int stride, VGImageFormat format) {
+	static const VGubyte pad[RAWIMAGE_OFFSET];
+	RawHeader hdr;
+	FILE *fp;
+	int y, rowbytes, ok;
+
+	rowbytes = w * 4;
+	fp = fopen(filename, "wb");
+	if (fp == NULL) {
+		return -1;
+	}
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, RAWIMAGE_MAGIC, 4);
+	hdr.version = RAWIMAGE_VERSION;
+	hdr.width = w;
+	hdr.height = h;
+	hdr.format = format;
+	hdr.stride = rowbytes;
+	hdr.offset = RAWIMAGE_OFFSET;
+	ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 && fwrite(pad, RAWIMAGE_OFFSET - sizeof(hdr), 1, fp) == 1;
+	for (y = 0; ok && y < h; y++) {
+		ok = fwrite(data + y * stride, rowbytes, 1, fp) == 1;
+	}
+	if (fclose(fp) != 0 || !ok) {
+		unlink(filename);
+		return -1;
+	}
+	return 0;
+}
+
+// RawImageFromJpeg decodes a JPEG file once, and writes it as a raw image file
+int RawImageFromJpeg(const char *jpegfile, const char *rawfile) {
+	VGubyte *data;
+	int w, h, err;
+
+	data = decodeJpeg(jpegfile, &w, &h);
+	if (data == NULL) {
+		return -1;
+	}
+	err = RawImageWrite(rawfile, data, w, h, w * 4, alphaformat(ALPHA_PREMULTIPLIED));	// JPEGs are opaque
+	free(data);
+	return err;
+}
+
+// rawformat reports whether a raw image file's format is one of the 32 bit VG formats it holds
+static int rawformat(uint32_t format) {
+	switch (format & ~0xc0u) {			   // without the channel order bits
+	case VG_sRGBX_8888:
+	case VG_sRGBA_8888:
+	case VG_sRGBA_8888_PRE:
+	case VG_lRGBX_8888:
+	case VG_lRGBA_8888:
+	case VG_lRGBA_8888_PRE:
+		return 1;
+	}
+	return 0;
+}
+
+// createImageFromRaw maps a raw image file and uploads it straight from the mapping,
+// returning the image and its dimensions.
+VGImage createImageFromRaw(const char *filename, int *w, int *h) {
+	const RawHeader *hdr;
+	struct stat st;
+	VGImage img = VG_INVALID_HANDLE;
+	void *map;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		printf("Failed opening '%s' for reading!\n", filename);
+		return VG_INVALID_HANDLE;
+	}
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(RawHeader)) {
+		close(fd);
+		return VG_INVALID_HANDLE;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return VG_INVALID_HANDLE;
+	}
+	hdr = (const RawHeader *)map;
+	if (memcmp(hdr->magic, RAWIMAGE_MAGIC, 4) != 0 || hdr->version != RAWIMAGE_VERSION) {
+		printf("'%s' is not a raw image file\n", filename);
+	} else if (hdr->width > 0 && hdr->height > 0 && hdr->width <= INT32_MAX / 4 && hdr->height <= INT32_MAX
+		   && rawformat(hdr->format) && hdr->stride >= hdr->width * 4 && hdr->stride <= INT32_MAX
+		   && (uint64_t) hdr->offset + (uint64_t) hdr->stride * hdr->height <= (uint64_t) st.st_size) {
+		img = vgCreateImage(hdr->format, hdr->width, hdr->height, VG_IMAGE_QUALITY_BETTER);
+		if (img != VG_INVALID_HANDLE) {
+			vgImageSubData(img, (const VGubyte *)map + hdr->offset, hdr->stride, hdr->format, 0, 0, hdr->width,
+				       hdr->height);
+			vgcheck("createImageFromRaw");
+			*w = hdr->width;
+			*h = hdr->height;
+		}
+	}
+	munmap(map, st.st_size);
+	return img;
+}
+
+// RawImage places a raw image file at (x,y)
+void RawImage(VGfloat x, VGfloat y, const char *filename) {
+	int w, h;
+	VGImage img = createImageFromRaw(filename, &w, &h);
+	if (img != VG_INVALID_HANDLE) {
+		vgSetPixels(x, y, img, 0, 0, w, h);
+		vgDestroyImage(img);
+	}
+	vgcheck("RawImage");
+}
@@ -0,0 +1,232 @@
+//
+// record: asynchronous frame recording
+//
+// RecordEnd reads the frame into one of a ring of buffers and swaps,
+// a background thread writes the buffers out. When the writer falls
+// behind and the ring is full the frame is dropped and counted, so
+// recording never stalls drawing on the output. With RECORD_DELTA
+// the writer delta compresses the frames (see delta.c) as it goes.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+#define RECORD_KEYFRAMES	300			   // frames from one keyframe to the next, for seeking
+
+struct Recorder {
+	FILE *fp;
+	int pipe;					   // fp is from popen
+	int x, y, width, height;			   // recorded rectangle of the window
+	int flags;					   // CAPTURE_ and RECORD_ flags
+	size_t framesize;
+	VGubyte *ring;					   // nbuffers frames
+	VGubyte *prev;					   // with RECORD_DELTA, the last frame written
+	VGubyte *delta;					   // with RECORD_DELTA, the encoded frame
+	int nbuffers;
+	int head;					   // next buffer to fill
+	int tail;					   // next buffer to write
+	int queued;
+	unsigned long frames;				   // frames written
+	unsigned long dropped;				   // frames dropped with the ring full
+	int error;
+	int quit;
+	pthread_t writer;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;				   // a frame was queued, or quit
+};
+
+// recordwriter writes queued frames until told to quit and the ring is empty
+static void *recordwriter(void *arg) {
+	Recorder *r = (Recorder *) arg;
+	VGubyte *frame;
+	size_t n;
+	int written;
+
+	pthread_mutex_lock(&r->lock);
+	for (;;) {
+		if (r->queued == 0) {
+			if (r->quit) {
+				break;
+			}
+			pthread_cond_wait(&r->wake, &r->lock);
+			continue;
+		}
+		frame = r->ring + (size_t) r->tail * r->framesize;
+		pthread_mutex_unlock(&r->lock);
+		written = 0;
+		if (r->error) {
+			// keep emptying the ring, so frames are not stuck
+		} else if (r->flags & RECORD_DELTA) {
+			// frames and the count of frames are only changed by this thread
+			n = DeltaEncode(r->delta, frame, r->frames % RECORD_KEYFRAMES != 0 ? r->prev : NULL, r->width, r->height);
+			r->error = fwrite(r->delta, n, 1, r->fp) != 1;
+			memcpy(r->prev, frame, r->framesize);
+			written = !r->error;
+		} else {
+			r->error = fwrite(frame, r->framesize, 1, r->fp) != 1;
+			written = !r->error;
+		}
+		pthread_mutex_lock(&r->lock);
+		r->tail = (r->tail + 1) % r->nbuffers;
+		r->queued--;
+		r->frames += written;
+	}
+	pthread_mutex_unlock(&r->lock);
+	return NULL;
+}
+
+// RecordOpen starts recording the w x h rectangle at (x,y) of the window, as raw frames like SaveEnd's,
+// to filename: a file, "-" for standard output, or "|command" to pipe to a command.
+// nbuffers frames (at least 2) may wait for the writer; flags are CAPTURE_ flags, and RECORD_DELTA
+// to write a delta compressed recording, for DeltaOpen, instead of raw frames.
+Recorder *RecordOpen(const char *filename, int x, int y, int w, int h, int nbuffers, int flags) {
+	VGubyte header[DELTA_HEADER];
+	Recorder *r;
+
+	if (w <= 0 || h <= 0) {
+		return NULL;
+	}
+	r = (Recorder *) calloc(1, sizeof(Recorder));
+	if (r == NULL) {
+		return NULL;
+	}
+	r->nbuffers = nbuffers < 2 ? 2 : nbuffers;
+	r->framesize = (size_t) w * h * 4;
+	r->ring = (VGubyte *) malloc(r->framesize * r->nbuffers);
+	if (flags & RECORD_DELTA) {
+		r->prev = (VGubyte *) malloc(r->framesize);
+		r->delta = (VGubyte *) malloc(DeltaBound(w, h));
+	}
+	if (r->ring == NULL || ((flags & RECORD_DELTA) && (r->prev == NULL || r->delta == NULL))) {
+		free(r->ring);
+		free(r->prev);
+		free(r->delta);
+		free(r);
+		return NULL;
+	}
+	if (strcmp(filename, "-") == 0) {
+		r->fp = stdout;
+	} else if (filename[0] == '|') {
+		r->fp = popen(filename + 1, "w");
+		r->pipe = 1;
+	} else {
+		r->fp = fopen(filename, "wb");
+	}
+	if (r->fp == NULL) {
+		free(r->ring);
+		free(r->prev);
+		free(r->delta);
+		free(r);
+		return NULL;
+	}
+	if (flags & RECORD_DELTA) {
+		DeltaHeader(header, w, h, flags & CAPTURE_TOPDOWN);
+		r->error = fwrite(header, sizeof(header), 1, r->fp) != 1;
+	}
+	r->x = x;
+	r->y = y;
+	r->width = w;
+	r->height = h;
+	r->flags = flags;
+	pthread_mutex_init(&r->lock, NULL);
+	pthread_cond_init(&r->wake, NULL);
+	if (pthread_create(&r->writer, NULL, recordwriter, r) != 0) {
+		if (r->pipe) {
+			pclose(r->fp);
+		} else if (r->fp != stdout) {
+			fclose(r->fp);
+		}
+		pthread_mutex_destroy(&r->lock);
+		pthread_cond_destroy(&r->wake);
+		free(r->ring);
+		free(r->prev);
+		free(r->delta);
+		free(r);
+		return NULL;
+	}
+	return r;
+}
+
+// RecordFrame queues the current frame for writing, or drops it if the ring is full
+void RecordFrame(Recorder * r) {
+	VGubyte *frame;
+	int full;
+
+	pthread_mutex_lock(&r->lock);
+	full = r->queued == r->nbuffers;
+	if (full) {
+		r->dropped++;
+	}
+	frame = r->ring + (size_t) r->head * r->framesize;
+	pthread_mutex_unlock(&r->lock);
+	if (full) {
+		return;
+	}
+	// the writer does not touch the head buffer until it is queued
+	if (CaptureRectInto(frame, r->width * 4, r->x, r->y, r->width, r->height, r->flags & ~RECORD_DELTA) != 0) {
+		pthread_mutex_lock(&r->lock);
+		r->dropped++;
+		pthread_mutex_unlock(&r->lock);
+		return;
+	}
+	pthread_mutex_lock(&r->lock);
+	r->head = (r->head + 1) % r->nbuffers;
+	r->queued++;
+	pthread_cond_signal(&r->wake);
+	pthread_mutex_unlock(&r->lock);
+}
+
+// RecordEnd records the frame, and ends the picture; with CAPTURE_DISPLAY the frame is shown first
+void RecordEnd(Recorder * r) {
+	if (r->flags & CAPTURE_DISPLAY) {
+		End();
+		RecordFrame(r);
+		return;
+	}
+	RecordFrame(r);
+	End();
+}
+
+// RecordStats returns the number of frames written and dropped so far; after a write error
+// the frames queued are discarded, and counted as neither
+void RecordStats(Recorder * r, unsigned long *frames, unsigned long *dropped) {
+	pthread_mutex_lock(&r->lock);
+	*frames = r->frames;
+	*dropped = r->dropped;
+	pthread_mutex_unlock(&r->lock);
+}
+
+// RecordClose writes the queued frames and closes the output, returning 0, or -1 on a write error
+int RecordClose(Recorder * r) {
+	int err;
+
+	if (r == NULL) {
+		return -1;
+	}
+	pthread_mutex_lock(&r->lock);
+	r->quit = 1;
+	pthread_cond_signal(&r->wake);
+	pthread_mutex_unlock(&r->lock);
+	pthread_join(r->writer, NULL);
+
+	err = r->error;
+	if (r->pipe) {
+		err |= pclose(r->fp) != 0;
+	} else if (r->fp == stdout) {
+		err |= fflush(stdout) != 0;
+	} else {
+		err |= fclose(r->fp) != 0;
+	}
+	pthread_mutex_destroy(&r->lock);
+	pthread_cond_destroy(&r->wake);
+	free(r->ring);
+	free(r->prev);
+	free(r->delta);
+	free(r);
+	return err ? -1 : 0;
+}
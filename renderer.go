@@ -0,0 +1,140 @@
+package openvg
+
+// The EGL and OpenVG context belongs to the thread that called Init, so the
+// package functions may only be called from the goroutine that called Init.
+// A Renderer owns that goroutine, so that any goroutine can send it work.
+
+// Renderer draws frames on a goroutine locked to the thread that owns the
+// graphics context. Frames are recorded in Batches by any goroutine, and
+// queued with Submit; when the queue is full, Submit waits for the renderer
+// to catch up. Only one Renderer may exist at a time, and the package
+// drawing functions may only be called from functions passed to Do.
+type Renderer struct {
+	Width, Height int
+
+	queue    chan request
+	free     chan *Batch
+	stopped  chan struct{}
+	retained *Retained // used by the render goroutine only
+}
+
+// request is a frame to draw, or a function to run, on the render goroutine
+type request struct {
+	batch *Batch
+	fn    func()
+	done  chan struct{}
+}
+
+// NewRenderer initializes the graphics subsystem on a new goroutine, which draws
+// up to depth queued frames before Submit waits. InitWindowSize may be called first.
+func NewRenderer(depth int) *Renderer {
+	if depth < 1 {
+		depth = 1
+	}
+	r := &Renderer{
+		queue:   make(chan request, depth),
+		free:    make(chan *Batch, depth+1),
+		stopped: make(chan struct{}),
+	}
+	ready := make(chan struct{})
+	go r.run(ready)
+	<-ready
+	return r
+}
+
+// run owns the graphics context until the queue is closed
+func (r *Renderer) run(ready chan struct{}) {
+	r.Width, r.Height = Init() // locks the goroutine to its thread
+	close(ready)
+	for q := range r.queue {
+		if q.batch != nil {
+			r.draw(q.batch)
+			select {
+			case r.free <- q.batch:
+			default:
+			}
+		}
+		if q.fn != nil {
+			q.fn()
+		}
+		if q.done != nil {
+			close(q.done)
+		}
+	}
+	if r.retained != nil {
+		r.retained.Close()
+	}
+	Finish()
+	close(r.stopped)
+}
+
+// draw draws a batch as a frame; in retained mode, only what changed from the last
+func (r *Renderer) draw(b *Batch) {
+	if r.retained == nil {
+		Start(r.Width, r.Height)
+		b.Flush()
+		End()
+		return
+	}
+	r.retained.Damage(b)
+	if StartDamaged(r.Width, r.Height) == 0 {
+		b.Reset() // nothing changed; the frame on the screen is already this one
+		return
+	}
+	b.Flush()
+	End()
+}
+
+// Retain puts the renderer in retained mode: each frame is compared with the last,
+// and only the window area of what changed is cleared and redrawn. It suits frames
+// that begin with BackgroundRGB and change a little at a time, like dashboards.
+func (r *Renderer) Retain() {
+	r.Do(func() {
+		if r.retained == nil {
+			r.retained = NewRetained()
+		}
+	})
+}
+
+// Batch returns an empty batch to record a frame in, reusing one already drawn if there is one
+func (r *Renderer) Batch() *Batch {
+	select {
+	case b := <-r.free:
+		b.Reset()
+		return b
+	default:
+		return NewBatch(4096)
+	}
+}
+
+// Submit queues a batch to be drawn as a frame, between Start and End, waiting while
+// the queue is full. The batch belongs to the renderer afterwards; get the next from Batch.
+func (r *Renderer) Submit(b *Batch) {
+	r.queue <- request{batch: b}
+}
+
+// TrySubmit queues a batch like Submit, but reports false instead of waiting when the
+// queue is full, so that a producer may drop the frame, or record a newer one.
+func (r *Renderer) TrySubmit(b *Batch) bool {
+	select {
+	case r.queue <- request{batch: b}:
+		return true
+	default:
+		return false
+	}
+}
+
+// Do runs f on the render goroutine, after the frames queued before it, and waits for it to return.
+// f may call the package functions, to load images or draw frames with Start and End.
+func (r *Renderer) Do(f func()) {
+	done := make(chan struct{})
+	r.queue <- request{fn: f, done: done}
+	<-done
+}
+
+// Close draws the queued frames, and shuts down the graphics subsystem.
+// The renderer may not be used afterwards.
+func (r *Renderer) Close() {
+	close(r.queue)
+	<-r.stopped
+}
@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <VG/openvg.h>
 #include <VG/vgu.h>
 #include "fontinfo.h"
@@ -12,6 +13,10 @@ extern "C" {
 	extern void TextMid(VGfloat, VGfloat, const char *, Fontinfo, int);
 	extern void TextEnd(VGfloat, VGfloat, const char *, Fontinfo, int);
 	extern VGfloat TextWidth(const char *, Fontinfo, int);
+	extern void TextN(VGfloat, VGfloat, const char *, int, Fontinfo, int);
+	extern void TextMidN(VGfloat, VGfloat, const char *, int, Fontinfo, int);
+	extern void TextEndN(VGfloat, VGfloat, const char *, int, Fontinfo, int);
+	extern VGfloat TextWidthN(const char *, int, Fontinfo, int);
 	extern void Cbezier(VGfloat, VGfloat, VGfloat, VGfloat, VGfloat, VGfloat, VGfloat, VGfloat);
 	extern void Qbezier(VGfloat, VGfloat, VGfloat, VGfloat, VGfloat, VGfloat);
 	extern void Polygon(VGfloat *, VGfloat *, VGint);
@@ -35,6 +40,9 @@ extern "C" {
 	extern void StrokeWidth(VGfloat);
 	extern void Stroke(unsigned int, unsigned int, unsigned int, VGfloat);
 	extern void Fill(unsigned int, unsigned int, unsigned int, VGfloat);
+	extern VGPaint ColorPaint(unsigned int, unsigned int, unsigned int, VGfloat);
+	extern void FillPaint(VGPaint);
+	extern void StrokePaint(VGPaint);
 	extern void RGBA(unsigned int, unsigned int, unsigned int, VGfloat, VGfloat[4]);
 	extern void RGB(unsigned int, unsigned int, unsigned int, VGfloat[4]);
 	extern void FillLinearGradient(VGfloat, VGfloat, VGfloat, VGfloat, VGfloat *, int);
@@ -65,6 +73,204 @@ extern "C" {
 	extern void CircleOutline(VGfloat, VGfloat, VGfloat);
 	extern void ArcOutline(VGfloat, VGfloat, VGfloat, VGfloat, VGfloat, VGfloat);
 	extern VGImage createImageFromJpeg(const char *);
+	extern VGubyte *decodeJpeg(const char *, int *, int *);
+	extern VGImageFormat rgbaformat();
+	extern VGubyte *decodeJpegThumbnail(const char *, int, int, int *, int *);
+	extern VGImage createThumbnailFromJpeg(const char *, int, int);
+	extern void Thumbnail(VGfloat, VGfloat, int, int, const char *);
+
+	// Pre-decoded raw image files
+	extern int RawImageWrite(const char *, const VGubyte *, int, int, int, VGImageFormat);
+	extern int RawImageFromJpeg(const char *, const char *);
+	extern VGImage createImageFromRaw(const char *, int *, int *);
+	extern void RawImage(VGfloat, VGfloat, const char *);
+
+	// Image alpha modes
+#define ALPHA_STRAIGHT		0			   // not premultiplied; blending premultiplies every frame
+#define ALPHA_PREMULTIPLY	1			   // premultiplied on the CPU once, at load time
+#define ALPHA_PREMULTIPLIED	2			   // already premultiplied
+	extern VGImageFormat alphaformat(int);
+	extern VGImage createImage(const VGubyte *, int, int, int, int);
+	extern void makeimageAlpha(VGfloat, VGfloat, int, int, VGubyte *, int);
+
+	// Prefetching image sequences
+	typedef struct Slideshow Slideshow;
+	extern Slideshow *SlideshowOpen(const char **, int, int, size_t);
+	extern VGImage SlideshowImage(Slideshow *, int, int *, int *);
+	extern void SlideshowPrefetch(Slideshow *);
+	extern void SlideshowShow(Slideshow *, int, VGfloat, VGfloat);
+	extern void SlideshowClose(Slideshow *);
+
+	// Persistent images for streamed rasters
+	typedef struct StreamImage StreamImage;
+	extern StreamImage *StreamImageCreate(int, int, int);
+	extern StreamImage *StreamImageCreateAlpha(int, int, int, int);
+	extern void StreamImageUpdate(StreamImage *, const VGubyte *, int);
+	extern void StreamImageUpdateRect(StreamImage *, const VGubyte *, int, int, int, int, int);
+	extern VGImage StreamImageHandle(StreamImage *);
+	extern void StreamImageDraw(StreamImage *, VGfloat, VGfloat);
+	extern void StreamImageDestroy(StreamImage *);
+
+	// Video frame conversion
+#define YUV_VIDEO	0				   // BT.601 luma 16..235
+#define YUV_FULL	1				   // JFIF luma 0..255
+	extern void I420toRGBA(VGubyte *, int, const VGubyte *, const VGubyte *, const VGubyte *, int, int, int, int, int);
+	extern void NV12toRGBA(VGubyte *, int, const VGubyte *, const VGubyte *, int, int, int, int, int);
+	extern void StreamImageUpdateI420(StreamImage *, const VGubyte *, const VGubyte *, const VGubyte *, int, int, int);
+	extern void StreamImageUpdateNV12(StreamImage *, const VGubyte *, const VGubyte *, int, int, int);
+
+	// Pixel format conversion
+	extern void RGBtoRGBA(VGubyte *, const VGubyte *, int);
+	extern void BGRtoRGBA(VGubyte *, const VGubyte *, int);
+	extern void GraytoRGBA(VGubyte *, const VGubyte *, int);
+	extern void SwizzleRGBA(VGubyte *, const VGubyte *, int);
+	extern void PremultiplyRGBA(VGubyte *, const VGubyte *, int);
+	extern void FlipRaster(VGubyte *, int, const VGubyte *, int, int, int);
+	extern void HalveRGBA(VGubyte *, int, const VGubyte *, int, int, int);
+
+	// Scaled images
+	typedef struct MipImage MipImage;
+	extern void DrawImageScaled(VGImage, VGfloat, VGfloat, VGfloat, VGfloat);
+	extern MipImage *MipImageCreate(const VGubyte *, int, int, int, int);
+	extern MipImage *MipImageFromJpeg(const char *);
+	extern void MipImageSize(MipImage *, int *, int *);
+	extern void MipImageDraw(MipImage *, VGfloat, VGfloat, VGfloat, VGfloat);
+	extern void MipImageDestroy(MipImage *);
+
+	// Images larger than a VGImage
+	typedef struct TiledImage TiledImage;
+	extern TiledImage *TiledImageOpen(const char *, int, size_t);
+	extern void TiledImageSize(TiledImage *, int *, int *);
+	extern void TiledImageDraw(TiledImage *, VGfloat, VGfloat, VGfloat, VGfloat, VGfloat, VGfloat, VGfloat);
+	extern void TiledImageClose(TiledImage *);
+
+	// Sprite atlases
+	typedef struct Atlas Atlas;
+	extern Atlas *AtlasCreate(int, int, int);
+	extern int AtlasAdd(Atlas *, const VGubyte *, int, int, int);
+	extern int AtlasAddJpeg(Atlas *, const char *);
+	extern VGImage AtlasSprite(Atlas *, int, int *, int *);
+	extern void AtlasDraw(Atlas *, int, VGfloat, VGfloat);
+	extern void AtlasDrawList(Atlas *, const int *, const VGfloat *, const VGfloat *, int);
+	extern void AtlasDestroy(Atlas *);
+
+	// Screen capture
+#define CAPTURE_TOPDOWN	1				   // top row first, as image files, not OpenVG's bottom row first
+#define CAPTURE_DISPLAY	4				   // as composited on the display, from a dispmanx snapshot
+	extern int CaptureRectInto(VGubyte *, int, int, int, int, int, int);
+	extern const VGubyte *CaptureRect(int, int, int, int, int);
+	extern const VGubyte *CaptureWindow(int, int *, int *);
+	extern void CaptureFree();
+
+	// Asynchronous frame recording
+#define RECORD_DELTA	2				   // delta compressed, not raw frames
+	typedef struct Recorder Recorder;
+	extern Recorder *RecordOpen(const char *, int, int, int, int, int, int);
+	extern void RecordFrame(Recorder *);
+	extern void RecordEnd(Recorder *);
+	extern void RecordStats(Recorder *, unsigned long *, unsigned long *);
+	extern int RecordClose(Recorder *);
+
+	// PNG files
+	extern int WritePNG(const char *, const VGubyte *, int, int, int, int);
+	extern void SaveEndPNG(const char *);
+
+	// Frames published in shared memory
+	typedef struct FrameShare FrameShare;
+	extern FrameShare *ShareOpen(const char *, int, int, int, int, int, int);
+	extern int ShareFrame(FrameShare *);
+	extern void ShareEnd(FrameShare *);
+	extern FrameShare *ShareAttach(const char *, int *, int *, int *);
+	extern const VGubyte *ShareNext(FrameShare *, unsigned long *, int);
+	extern int ShareCheck(FrameShare *, unsigned long);
+	extern void ShareClose(FrameShare *);
+
+	// Delta compressed recordings
+#define DELTA_HEADER	32				   // bytes before the first frame
+	typedef struct DeltaReader DeltaReader;
+	extern void DeltaHeader(VGubyte *, int, int, int);
+	extern size_t DeltaBound(int, int);
+	extern size_t DeltaEncode(VGubyte *, const VGubyte *, const VGubyte *, int, int);
+	extern DeltaReader *DeltaOpen(const char *, int *, int *, int *);
+	extern const VGubyte *DeltaNext(DeltaReader *);
+	extern void DeltaClose(DeltaReader *);
+
+	// Command buffers: an opcode, then its arguments as floats, except where noted
+#define CMD_RECT	1				   // x y w h
+#define CMD_ROUNDRECT	2				   // x y w h rw rh
+#define CMD_ELLIPSE	3				   // x y w h
+#define CMD_CIRCLE	4				   // x y d
+#define CMD_LINE	5				   // x1 y1 x2 y2
+#define CMD_ARC		6				   // x y w h sa aext
+#define CMD_QBEZIER	7				   // sx sy cx cy ex ey
+#define CMD_CBEZIER	8				   // sx sy cx cy px py ex ey
+#define CMD_POLYGON	9				   // int n, x[n], y[n]
+#define CMD_POLYLINE	10				   // int n, x[n], y[n]
+#define CMD_FILL	11				   // r g b (0..255) a (0..1)
+#define CMD_STROKE	12				   // r g b a
+#define CMD_STROKEWIDTH	13				   // w
+#define CMD_TRANSLATE	14				   // x y
+#define CMD_ROTATE	15				   // r
+#define CMD_SCALE	16				   // x y
+#define CMD_SHEAR	17				   // x y
+#define CMD_TEXT	18				   // int font, int size, int align, x, y, int words, text with NUL
+#define CMD_BACKGROUND	19				   // r g b a
+#define CMD_CLIPRECT	20				   // x y w h
+#define CMD_CLIPEND	21
+#define CMD_COUNT	22
+#define CMD_FONT_SANS	0
+#define CMD_FONT_SERIF	1
+#define CMD_FONT_MONO	2
+#define CMD_ALIGN_START	0
+#define CMD_ALIGN_MID	1
+#define CMD_ALIGN_END	2
+	extern void DrawCommands(const VGint *, int);
+
+	// Frame pacing and statistics
+#define FRAME_HISTORY	240				   // frames in the rolling statistics
+#define FRAME_BUCKETS	32				   // histogram buckets
+#define FRAME_BUCKETMS	2				   // ms in each; the last holds all longer times
+	typedef struct {
+		int count;				   // frames timed
+		VGfloat mean, max;			   // ms
+		unsigned int hist[FRAME_BUCKETS];	   // frames in each FRAME_BUCKETMS ms
+	} FrameTimes;
+	typedef struct {
+		unsigned long frames;			   // since the start, or FrameStatsReset
+		unsigned long janks;			   // frames more than 1.5 periods after the last
+		VGfloat period;				   // ms expected between frames
+		int count;				   // frames in the times, up to FRAME_HISTORY
+		int recentjanks;			   // janks among them
+		FrameTimes cpu, swap, interval;
+	} FrameStats;
+	extern void FrameRate(VGfloat);
+	extern int FrameVsync(int);
+	extern void FrameStatsRead(FrameStats *);
+	extern void FrameStatsReset();
+
+	// Surface format and swap behavior, before init
+#define SURFACE_RGB565	1				   // 16 bit color, without alpha; half the memory traffic of RGBA8888
+#define SURFACE_OPAQUE	2				   // 24 bit color, without alpha
+#define SURFACE_DISCARD	4				   // buffers not preserved on swap, for programs that redraw every pixel
+	extern void initSurface(int, int, int);
+
+	// Error checking
+#define ERRORS_OFF	0				   // never checked
+#define ERRORS_SAMPLED	1				   // at the end of every nth frame
+#define ERRORS_DEBUG	2				   // after every call
+#define ERRORS_SAMPLE	60				   // frames from one check to the next, by default
+	typedef void (*ErrorHandler) (const char *, VGErrorCode, int);
+	extern void ErrorPolicy(int, int);
+	extern void ErrorCallback(ErrorHandler);
+
+	// Damage: redrawing only what changed
+	extern void InvalidateRect(VGfloat, VGfloat, VGfloat, VGfloat);
+	extern void InvalidateWindow();
+	extern int StartDamaged(int, int);
+	typedef struct Retained Retained;
+	extern Retained *RetainedOpen();
+	extern void RetainedDamage(Retained *, const VGint *, int);
+	extern void RetainedClose(Retained *);
 #if defined(__cplusplus)
 }
 #endif
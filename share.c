@@ -0,0 +1,281 @@
+//
+// share: frames published in shared memory
+//
+// ShareEnd reads each frame straight into the next slot of a ring in a
+// POSIX shared memory object, so other processes map it and read the
+// pixels without copies, files or pipes. Each slot carries the number
+// of the frame in it, zero while it is written (a sequence lock): a
+// reader checks the number is unchanged after reading, to know the
+// writer did not lap it. Readers sleep on a futex on the number of the
+// newest frame, which the writer wakes after each frame.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+#define SHARE_MAGIC	"VGSH"
+#define SHARE_VERSION	1
+#define SHARE_ALIGN	4096				   // slots start on a page
+
+// ShareHeader begins the shared memory, followed by the slot numbers, then the slots
+typedef struct {
+	char magic[4];
+	uint32_t version;
+	uint32_t width, height;
+	uint32_t flags;					   // CAPTURE_ flags
+	uint32_t nslots;
+	uint32_t offset;				   // of the first slot
+	uint32_t slotsize;				   // width*height*4
+	uint32_t latest;				   // newest frame, 0 before the first; the futex
+	uint32_t reserved[7];
+	uint32_t seq[];					   // frame in each slot, 0 while written
+} ShareHeader;
+
+struct FrameShare {
+	ShareHeader *hdr;
+	size_t size;					   // of the mapping
+	int owner;					   // the publisher, who removes the object
+	int x, y;					   // published rectangle of the window
+	int flags;					   // CAPTURE_ flags
+	uint32_t frame;					   // last frame published
+	char name[NAME_MAX];
+};
+
+// futex calls the futex system call, which has no C library wrapper
+static int futex(uint32_t * addr, int op, uint32_t val, const struct timespec *timeout) {
+	return syscall(SYS_futex, addr, op, val, timeout, NULL, 0);
+}
+
+// sharename makes a shared memory object name, which begins with a slash
+static void sharename(char *dst, const char *name) {
+	snprintf(dst, NAME_MAX, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+// ShareOpen creates the shared memory object name, and publishes the w x h rectangle at (x,y)
+// of the window in it, in a ring of nslots frames (at least 2). flags are CAPTURE_ flags.
+FrameShare *ShareOpen(const char *name, int x, int y, int w, int h, int nslots, int flags) {
+	FrameShare *s;
+	ShareHeader *hdr;
+	size_t offset, slotsize;
+	int fd;
+
+	if (w <= 0 || h <= 0 || (size_t) w * h > UINT32_MAX / 4) {
+		return NULL;
+	}
+	nslots = nslots < 2 ? 2 : nslots;
+	s = (FrameShare *) calloc(1, sizeof(FrameShare));
+	if (s == NULL) {
+		return NULL;
+	}
+	sharename(s->name, name);
+	slotsize = (size_t) w * h * 4;
+	offset = (sizeof(ShareHeader) + nslots * sizeof(uint32_t) + SHARE_ALIGN - 1) / SHARE_ALIGN * SHARE_ALIGN;
+	s->size = offset + slotsize * nslots;
+	shm_unlink(s->name);				   // left by a publisher that did not close; readers keep their mapping
+	fd = shm_open(s->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0) {
+		free(s);
+		return NULL;
+	}
+	if (ftruncate(fd, s->size) != 0) {
+		close(fd);
+		shm_unlink(s->name);
+		free(s);
+		return NULL;
+	}
+	hdr = (ShareHeader *) mmap(NULL, s->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (hdr == MAP_FAILED) {
+		shm_unlink(s->name);
+		free(s);
+		return NULL;
+	}
+	hdr->version = SHARE_VERSION;
+	hdr->width = w;
+	hdr->height = h;
+	hdr->flags = flags & CAPTURE_TOPDOWN;
+	hdr->nslots = nslots;
+	hdr->offset = offset;
+	hdr->slotsize = slotsize;
+	// the magic last, so a reader that sees it sees the rest
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(hdr->magic, SHARE_MAGIC, 4);
+	s->hdr = hdr;
+	s->owner = 1;
+	s->x = x;
+	s->y = y;
+	s->flags = flags;
+	return s;
+}
+
+// ShareFrame reads the current frame into the next slot, and wakes the readers.
+// Returns 0, or -1 if the rectangle is not within the window.
+int ShareFrame(FrameShare * s) {
+	ShareHeader *hdr = s->hdr;
+	uint32_t n = s->frame + 1, slot;
+	VGubyte *dst;
+
+	if (n == 0) {
+		n = 1;					   // 0 means no frame
+	}
+	slot = n % hdr->nslots;
+	dst = (VGubyte *) hdr + hdr->offset + (size_t) slot * hdr->slotsize;
+	__atomic_store_n(&hdr->seq[slot], 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	if (CaptureRectInto(dst, hdr->width * 4, s->x, s->y, hdr->width, hdr->height, s->flags) != 0) {
+		return -1;				   // the slot stays marked as being written
+	}
+	__atomic_store_n(&hdr->seq[slot], n, __ATOMIC_RELEASE);
+	__atomic_store_n(&hdr->latest, n, __ATOMIC_RELEASE);
+	futex(&hdr->latest, FUTEX_WAKE, INT_MAX, NULL);
+	s->frame = n;
+	return 0;
+}
+
+// ShareEnd publishes the frame, and ends the picture; with CAPTURE_DISPLAY the frame is shown first
+void ShareEnd(FrameShare * s) {
+	if (s->flags & CAPTURE_DISPLAY) {
+		End();
+		ShareFrame(s);
+		return;
+	}
+	ShareFrame(s);
+	End();
+}
+
+// ShareAttach maps the shared memory object name, published by another process, for reading,
+// returning the frame dimensions and CAPTURE_ flags
+FrameShare *ShareAttach(const char *name, int *w, int *h, int *flags) {
+	FrameShare *s;
+	ShareHeader *hdr;
+	struct stat st;
+	char magic[4];
+	int fd;
+
+	s = (FrameShare *) calloc(1, sizeof(FrameShare));
+	if (s == NULL) {
+		return NULL;
+	}
+	sharename(s->name, name);
+	fd = shm_open(s->name, O_RDONLY, 0);
+	if (fd < 0) {
+		free(s);
+		return NULL;
+	}
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(ShareHeader)) {
+		close(fd);
+		free(s);
+		return NULL;
+	}
+	s->size = st.st_size;
+	hdr = (ShareHeader *) mmap(NULL, s->size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (hdr == MAP_FAILED) {
+		free(s);
+		return NULL;
+	}
+	s->hdr = hdr;
+	// the magic first, then the rest, pairing with the fence before the writer stores it
+	memcpy(magic, hdr->magic, 4);
+	if (memcmp(magic, SHARE_MAGIC, 4) != 0) {
+		ShareClose(s);
+		return NULL;
+	}
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	if (hdr->version != SHARE_VERSION || hdr->nslots == 0
+	    || hdr->offset < sizeof(ShareHeader) + (size_t) hdr->nslots * sizeof(uint32_t)
+	    || (size_t) hdr->offset + (size_t) hdr->slotsize * hdr->nslots > s->size
+	    || hdr->slotsize != (size_t) hdr->width * hdr->height * 4) {
+		ShareClose(s);
+		return NULL;
+	}
+	*w = hdr->width;
+	*h = hdr->height;
+	*flags = hdr->flags;
+	return s;
+}
+
+// ShareNext waits up to timeout milliseconds (forever if negative) for a frame newer than *seq,
+// returning its pixels, in the shared memory, and setting *seq to its number; or NULL on timeout.
+// Start with *seq 0. Frames are skipped if the reader falls behind; after reading the pixels,
+// ShareCheck tells whether the writer has since reused the slot.
+const VGubyte *ShareNext(FrameShare * s, unsigned long *seq, int timeout) {
+	ShareHeader *hdr = s->hdr;
+	struct timespec now, deadline, wait;
+	uint32_t n, slot;
+
+	if (timeout > 0) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += timeout / 1000;
+		deadline.tv_nsec += (long)(timeout % 1000) * 1000000;
+		if (deadline.tv_nsec >= 1000000000) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+	}
+	for (;;) {
+		n = __atomic_load_n(&hdr->latest, __ATOMIC_ACQUIRE);
+		if (n != 0 && n != (uint32_t) * seq) {
+			slot = n % hdr->nslots;
+			if (__atomic_load_n(&hdr->seq[slot], __ATOMIC_ACQUIRE) == n) {
+				*seq = n;
+				return (const VGubyte *)hdr + hdr->offset + (size_t) slot * hdr->slotsize;
+			}
+			continue;			   // overwritten already; take the newer frame
+		}
+		if (timeout == 0) {
+			return NULL;
+		}
+		if (timeout < 0) {
+			futex(&hdr->latest, FUTEX_WAIT, n, NULL);
+			continue;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		wait.tv_sec = deadline.tv_sec - now.tv_sec;
+		wait.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+		if (wait.tv_nsec < 0) {
+			wait.tv_sec--;
+			wait.tv_nsec += 1000000000;
+		}
+		if (wait.tv_sec < 0) {
+			return NULL;
+		}
+		// returns at once if latest is no longer n
+		futex(&hdr->latest, FUTEX_WAIT, n, &wait);
+	}
+}
+
+// ShareCheck reports whether frame seq, returned by ShareNext, is still in its slot,
+// so the pixels read since are whole
+int ShareCheck(FrameShare * s, unsigned long seq) {
+	ShareHeader *hdr = s->hdr;
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&hdr->seq[seq % hdr->nslots], __ATOMIC_RELAXED) == (uint32_t) seq;
+}
+
+// ShareClose unmaps the shared memory, and removes the object if this process published it
+void ShareClose(FrameShare * s) {
+	if (s == NULL) {
+		return;
+	}
+	munmap(s->hdr, s->size);
+	if (s->owner) {
+		shm_unlink(s->name);
+	}
+	free(s);
+}
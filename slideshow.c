@@ -0,0 +1,282 @@
+//
+// slideshow: prefetching image sequences
+//
+// A background thread decodes the images following the current one,
+// the drawing thread uploads them to VGImages, so showing the next
+// image does not wait on the JPEG decoder.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+#include "vgcheck.h"
+
+// slide states
+enum { SLIDE_EMPTY, SLIDE_DECODING, SLIDE_DECODED, SLIDE_UPLOADED, SLIDE_FAILED };
+
+typedef struct {
+	int state;
+	int width;
+	int height;
+	VGubyte *data;					   // decoded raster, until uploaded
+	VGImage image;					   // uploaded image
+} Slide;
+
+struct Slideshow {
+	char **paths;
+	Slide *slides;
+	int count;
+	int ahead;					   // number of images kept after the current one
+	size_t budget;					   // bytes allowed for prefetched images, 0 for no limit
+	size_t used;
+	int current;
+	int quit;
+	pthread_t worker;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;				   // the worker has something to do
+	pthread_cond_t decoded;				   // a decode has finished
+};
+
+// slidesize is the memory held by a decoded or uploaded slide
+static size_t slidesize(Slide * s) {
+	return (size_t) s->width * s->height * 4;
+}
+
+// inwindow reports whether slide i is the current slide or one of those ahead of it
+static int inwindow(Slideshow * ss, int i) {
+	int d = (i - ss->current + ss->count) % ss->count;
+	return d <= ss->ahead;
+}
+
+// decodeslide decodes slide i, with the lock held on entry and exit
+static void decodeslide(Slideshow * ss, int i) {
+	Slide *s = &ss->slides[i];
+	VGubyte *data;
+	int w, h;
+
+	s->state = SLIDE_DECODING;
+	pthread_mutex_unlock(&ss->lock);
+	data = decodeJpeg(ss->paths[i], &w, &h);
+	pthread_mutex_lock(&ss->lock);
+
+	if (data == NULL) {
+		s->state = SLIDE_FAILED;
+	} else if (!inwindow(ss, i)) {			   // moved on while decoding
+		free(data);
+		s->state = SLIDE_EMPTY;
+	} else {
+		s->data = data;
+		s->width = w;
+		s->height = h;
+		s->state = SLIDE_DECODED;
+		ss->used += slidesize(s);
+	}
+	pthread_cond_broadcast(&ss->decoded);
+}
+
+// nextslide returns the next slide to prefetch, or -1 if the window is full
+static int nextslide(Slideshow * ss) {
+	int d, i;
+	for (d = 1; d <= ss->ahead; d++) {
+		i = (ss->current + d) % ss->count;
+		if (ss->slides[i].state != SLIDE_EMPTY) {
+			continue;
+		}
+		if (ss->budget > 0 && ss->used >= ss->budget) {
+			return -1;
+		}
+		return i;
+	}
+	return -1;
+}
+
+// slideworker decodes images ahead of the current one
+static void *slideworker(void *arg) {
+	Slideshow *ss = (Slideshow *) arg;
+	int i;
+
+	pthread_mutex_lock(&ss->lock);
+	while (!ss->quit) {
+		i = nextslide(ss);
+		if (i < 0) {
+			pthread_cond_wait(&ss->wake, &ss->lock);
+			continue;
+		}
+		decodeslide(ss, i);
+	}
+	pthread_mutex_unlock(&ss->lock);
+	return NULL;
+}
+
+// releaseslide frees a slide's raster or image, with the lock held
+static void releaseslide(Slideshow * ss, Slide * s) {
+	switch (s->state) {
+	case SLIDE_DECODED:
+		free(s->data);
+		s->data = NULL;
+		break;
+	case SLIDE_UPLOADED:
+		vgDestroyImage(s->image);
+		s->image = VG_INVALID_HANDLE;
+		break;
+	default:
+		return;
+	}
+	ss->used -= slidesize(s);
+	s->state = SLIDE_EMPTY;
+}
+
+// uploadslide moves a decoded slide to a VGImage, with the lock held
+static void uploadslide(Slideshow * ss, Slide * s) {
+	s->image = createImage(s->data, s->width, s->height, s->width * 4, ALPHA_PREMULTIPLIED);	// JPEGs are opaque
+	free(s->data);
+	s->data = NULL;
+	if (s->image == VG_INVALID_HANDLE) {
+		ss->used -= slidesize(s);
+		s->state = SLIDE_FAILED;
+		return;
+	}
+	s->state = SLIDE_UPLOADED;
+}
+
+// SlideshowOpen prepares a sequence of n JPEG files, keeping up to ahead images
+// after the current one decoded and uploaded, within budget bytes (0 for no limit).
+Slideshow *SlideshowOpen(const char **paths, int n, int ahead, size_t budget) {
+	Slideshow *ss;
+	int i;
+
+	if (n < 1) {
+		return NULL;
+	}
+	ss = (Slideshow *) calloc(1, sizeof(Slideshow));
+	if (ss == NULL) {
+		return NULL;
+	}
+	ss->paths = (char **)calloc(n, sizeof(char *));
+	ss->slides = (Slide *) calloc(n, sizeof(Slide));
+	if (ss->paths == NULL || ss->slides == NULL) {
+		free(ss->paths);
+		free(ss->slides);
+		free(ss);
+		return NULL;
+	}
+	for (i = 0; i < n; i++) {
+		ss->paths[i] = strdup(paths[i]);
+	}
+	if (ahead >= n) {
+		ahead = n - 1;
+	}
+	ss->count = n;
+	ss->ahead = ahead < 0 ? 0 : ahead;
+	ss->budget = budget;
+	pthread_mutex_init(&ss->lock, NULL);
+	pthread_cond_init(&ss->wake, NULL);
+	pthread_cond_init(&ss->decoded, NULL);
+	if (pthread_create(&ss->worker, NULL, slideworker, ss) != 0) {
+		for (i = 0; i < n; i++) {
+			free(ss->paths[i]);
+		}
+		pthread_mutex_destroy(&ss->lock);
+		pthread_cond_destroy(&ss->wake);
+		pthread_cond_destroy(&ss->decoded);
+		free(ss->paths);
+		free(ss->slides);
+		free(ss);
+		return NULL;
+	}
+	return ss;
+}
+
+// SlideshowImage makes image index the current one, returning it with its dimensions.
+// Images behind the new current one are released, those ahead are prefetched.
+VGImage SlideshowImage(Slideshow * ss, int index, int *w, int *h) {
+	Slide *s;
+	VGImage img = VG_INVALID_HANDLE;
+	int i;
+
+	if (ss == NULL || index < 0 || index >= ss->count) {
+		return VG_INVALID_HANDLE;
+	}
+	pthread_mutex_lock(&ss->lock);
+	ss->current = index;
+	for (i = 0; i < ss->count; i++) {
+		if (!inwindow(ss, i)) {
+			releaseslide(ss, &ss->slides[i]);
+		}
+	}
+	pthread_cond_signal(&ss->wake);
+
+	s = &ss->slides[index];
+	while (s->state == SLIDE_DECODING) {
+		pthread_cond_wait(&ss->decoded, &ss->lock);
+	}
+	if (s->state == SLIDE_EMPTY) {			   // not prefetched, decode it here
+		decodeslide(ss, index);
+	}
+	if (s->state == SLIDE_DECODED) {
+		uploadslide(ss, s);
+	}
+	if (s->state == SLIDE_UPLOADED) {
+		img = s->image;
+		*w = s->width;
+		*h = s->height;
+	}
+	pthread_mutex_unlock(&ss->lock);
+	return img;
+}
+
+// SlideshowPrefetch uploads the images decoded ahead of the current one;
+// call it while the current image is on display.
+void SlideshowPrefetch(Slideshow * ss) {
+	int i;
+
+	if (ss == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&ss->lock);
+	for (i = 0; i < ss->count; i++) {
+		if (ss->slides[i].state == SLIDE_DECODED && inwindow(ss, i)) {
+			uploadslide(ss, &ss->slides[i]);
+		}
+	}
+	pthread_mutex_unlock(&ss->lock);
+}
+
+// SlideshowShow places image index at (x,y), making it the current one
+void SlideshowShow(Slideshow * ss, int index, VGfloat x, VGfloat y) {
+	int w, h;
+	VGImage img = SlideshowImage(ss, index, &w, &h);
+	if (img != VG_INVALID_HANDLE) {
+		vgSetPixels(x, y, img, 0, 0, w, h);
+	}
+	vgcheck("SlideshowShow");
+}
+
+// SlideshowClose stops prefetching and frees all images
+void SlideshowClose(Slideshow * ss) {
+	int i;
+
+	if (ss == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&ss->lock);
+	ss->quit = 1;
+	pthread_cond_signal(&ss->wake);
+	pthread_mutex_unlock(&ss->lock);
+	pthread_join(ss->worker, NULL);
+
+	for (i = 0; i < ss->count; i++) {
+		releaseslide(ss, &ss->slides[i]);
+		free(ss->paths[i]);
+	}
+	pthread_mutex_destroy(&ss->lock);
+	pthread_cond_destroy(&ss->wake);
+	pthread_cond_destroy(&ss->decoded);
+	free(ss->paths);
+	free(ss->slides);
+	free(ss);
+}
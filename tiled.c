@@ -0,0 +1,301 @@
+//
+// tiled: JPEG images larger than a VGImage
+//
+// The picture is split into square tiles, each its own VGImage.
+// Drawing decodes only the tiles that fall in the viewport, in one
+// pass over the file, and evicts the least recently drawn tiles when
+// the total goes over the budget.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <jpeglib.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+#include "vgcheck.h"
+
+typedef struct {
+	VGImage image;
+	unsigned int drawn;				   // frame the tile was last drawn in
+} Tile;
+
+struct TiledImage {
+	char *filename;
+	int width;
+	int height;
+	int tilesize;
+	int cols;
+	int rows;
+	Tile *tiles;					   // rows of tiles, bottom row first
+	size_t budget;					   // bytes allowed for tiles, 0 for no limit
+	size_t used;
+	unsigned int frame;
+};
+
+// tilewidth and tileheight are the dimensions of tile (c, r); the last column and row may be short
+static int tilewidth(TiledImage * ti, int c) {
+	return c == ti->cols - 1 ? ti->width - c * ti->tilesize : ti->tilesize;
+}
+
+static int tileheight(TiledImage * ti, int r) {
+	return r == ti->rows - 1 ? ti->height - r * ti->tilesize : ti->tilesize;
+}
+
+// TiledImageOpen prepares a JPEG file for tiled display, reading only its header.
+// tilesize is the tile edge (0 for 512), budget the bytes allowed for decoded tiles (0 for no limit).
+TiledImage *TiledImageOpen(const char *filename, int tilesize, size_t budget) {
+	struct jpeg_decompress_struct jdc;
+	struct jpeg_error_mgr jerr;
+	TiledImage *ti;
+	FILE *infile;
+	VGint max;
+
+	infile = fopen(filename, "rb");
+	if (infile == NULL) {
+		printf("Failed opening '%s' for reading!\n", filename);
+		return NULL;
+	}
+	ti = (TiledImage *) calloc(1, sizeof(TiledImage));
+	if (ti == NULL) {
+		fclose(infile);
+		return NULL;
+	}
+	jdc.err = jpeg_std_error(&jerr);
+	jpeg_create_decompress(&jdc);
+	jpeg_stdio_src(&jdc, infile);
+	jpeg_read_header(&jdc, TRUE);
+	ti->width = jdc.image_width;
+	ti->height = jdc.image_height;
+	jpeg_destroy_decompress(&jdc);
+	fclose(infile);
+
+	if (tilesize <= 0) {
+		tilesize = 512;
+	}
+	max = vgGeti(VG_MAX_IMAGE_WIDTH) < vgGeti(VG_MAX_IMAGE_HEIGHT) ? vgGeti(VG_MAX_IMAGE_WIDTH) : vgGeti(VG_MAX_IMAGE_HEIGHT);
+	if (max > 0 && tilesize > max) {
+		tilesize = max;
+	}
+	ti->tilesize = tilesize;
+	ti->cols = (ti->width + tilesize - 1) / tilesize;
+	ti->rows = (ti->height + tilesize - 1) / tilesize;
+	ti->budget = budget;
+	ti->filename = strdup(filename);
+	ti->tiles = (Tile *) calloc(ti->cols * ti->rows, sizeof(Tile));
+	if (ti->filename == NULL || ti->tiles == NULL) {
+		TiledImageClose(ti);
+		return NULL;
+	}
+	return ti;
+}
+
+// TiledImageSize returns the dimensions of the whole picture
+void TiledImageSize(TiledImage * ti, int *w, int *h) {
+	*w = ti->width;
+	*h = ti->height;
+}
+
+// bandmissing reports whether tile row r has tiles in columns c0..c1 that are not loaded
+static int bandmissing(TiledImage * ti, int r, int c0, int c1) {
+	int c;
+	for (c = c0; c <= c1; c++) {
+		if (ti->tiles[r * ti->cols + c].image == VG_INVALID_HANDLE) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// loadtiles decodes the missing tiles in columns c0..c1 of rows r0..r1, in one pass over the file.
+// Rows and columns outside the range are skipped, and with libjpeg-turbo not decompressed.
+static void loadtiles(TiledImage * ti, int c0, int c1, int r0, int r1) {
+	struct jpeg_decompress_struct jdc;
+	struct jpeg_error_mgr jerr;
+	JSAMPARRAY buffer;
+	JDIMENSION xoff, cw;
+	FILE *infile;
+	VGubyte *band, *row;
+	Tile *t;
+	int r, c, line, top, th, tw, k, bbpp;
+
+	infile = fopen(ti->filename, "rb");
+	if (infile == NULL) {
+		return;
+	}
+	jdc.err = jpeg_std_error(&jerr);
+	jpeg_create_decompress(&jdc);
+	jpeg_stdio_src(&jdc, infile);
+	jpeg_read_header(&jdc, TRUE);
+#ifdef JCS_EXTENSIONS
+	if (jdc.jpeg_color_space == JCS_YCbCr || jdc.jpeg_color_space == JCS_RGB) {
+		jdc.out_color_space = JCS_EXT_RGBA;
+	}
+#endif
+	jpeg_start_decompress(&jdc);
+#ifdef LIBJPEG_TURBO_VERSION_NUMBER
+	// crop a block wider than the tiles, since upsampled chroma differs at the edges of the crop
+	xoff = c0 * ti->tilesize > 16 ? c0 * ti->tilesize - 16 : 0;
+	cw = (c1 + 1) * ti->tilesize + 16 < ti->width ? (c1 + 1) * ti->tilesize + 16 - xoff : ti->width - xoff;
+	jpeg_crop_scanline(&jdc, &xoff, &cw);		   // may widen to a block boundary
+#else
+	xoff = 0;
+	cw = ti->width;
+#endif
+	bbpp = jdc.output_components;
+	buffer = (*jdc.mem->alloc_sarray) ((j_common_ptr) & jdc, JPOOL_IMAGE, jdc.output_width * bbpp, 1);
+	band = (VGubyte *) malloc(cw * ti->tilesize * 4);
+	if (band == NULL) {
+		jpeg_abort_decompress(&jdc);
+		jpeg_destroy_decompress(&jdc);
+		fclose(infile);
+		return;
+	}
+	// the top tile row comes first in the file
+	for (r = r1; r >= r0; r--) {
+		th = tileheight(ti, r);
+		top = ti->height - (r * ti->tilesize + th);	// first scanline of the row
+		if (jdc.output_scanline < (JDIMENSION) top) {
+#ifdef LIBJPEG_TURBO_VERSION_NUMBER
+			jpeg_skip_scanlines(&jdc, top - jdc.output_scanline);
+#else
+			while (jdc.output_scanline < (JDIMENSION) top) {
+				jpeg_read_scanlines(&jdc, buffer, 1);
+			}
+#endif
+		}
+		if (!bandmissing(ti, r, c0, c1)) {
+			continue;
+		}
+		for (k = 0; k < th; k++) {
+			row = band + (th - 1 - k) * cw * 4;   // bottom row first
+			if (bbpp == 4) {
+				jpeg_read_scanlines(&jdc, &row, 1);
+			} else {
+				jpeg_read_scanlines(&jdc, buffer, 1);
+				line = jdc.output_width < cw ? jdc.output_width : cw;
+				if (bbpp == 3) {
+					RGBtoRGBA(row, buffer[0], line);
+				} else {
+					GraytoRGBA(row, buffer[0], line);
+				}
+			}
+		}
+		for (c = c0; c <= c1; c++) {
+			t = &ti->tiles[r * ti->cols + c];
+			if (t->image != VG_INVALID_HANDLE) {
+				continue;
+			}
+			tw = tilewidth(ti, c);
+			t->image = createImage(band + (c * ti->tilesize - xoff) * 4, tw, th, cw * 4, ALPHA_PREMULTIPLIED);
+			if (t->image != VG_INVALID_HANDLE) {
+				ti->used += (size_t) tw * th * 4;
+			}
+		}
+	}
+	free(band);
+	jpeg_abort_decompress(&jdc);			   // the rest of the file is not needed
+	jpeg_destroy_decompress(&jdc);
+	fclose(infile);
+}
+
+// evict frees the least recently drawn tiles, not drawn this frame, until the budget is met
+static void evict(TiledImage * ti) {
+	Tile *t, *oldest;
+	int i, n = ti->cols * ti->rows;
+
+	while (ti->budget > 0 && ti->used > ti->budget) {
+		oldest = NULL;
+		for (i = 0; i < n; i++) {
+			t = &ti->tiles[i];
+			if (t->image != VG_INVALID_HANDLE && t->drawn != ti->frame && (oldest == NULL || t->drawn < oldest->drawn)) {
+				oldest = t;
+			}
+		}
+		if (oldest == NULL) {
+			return;
+		}
+		i = oldest - ti->tiles;
+		ti->used -= (size_t) tilewidth(ti, i % ti->cols) * tileheight(ti, i / ti->cols) * 4;
+		vgDestroyImage(oldest->image);
+		oldest->image = VG_INVALID_HANDLE;
+	}
+}
+
+// TiledImageDraw fills the viewport (vx, vy, vw, vh) with the picture zoomed by zoom,
+// with picture point (cx, cy) (from the lower left) at the center of the viewport.
+// Tiles are drawn whole, so they may extend past the viewport; use ClipRect to trim them.
+void TiledImageDraw(TiledImage * ti, VGfloat cx, VGfloat cy, VGfloat zoom, VGfloat vx, VGfloat vy, VGfloat vw, VGfloat vh) {
+	VGfloat mm[9], ox, oy, ts;
+	VGint quality;
+	Tile *t;
+	int c0, c1, r0, r1, r, c;
+
+	if (zoom <= 0) {
+		return;
+	}
+	// picture region in the viewport, in tiles
+	ts = ti->tilesize;
+	ox = cx - vw / 2 / zoom;
+	oy = cy - vh / 2 / zoom;
+	c0 = (int)floorf(ox / ts);
+	r0 = (int)floorf(oy / ts);
+	c1 = (int)floorf((ox + vw / zoom) / ts);
+	r1 = (int)floorf((oy + vh / zoom) / ts);
+	c0 = c0 < 0 ? 0 : c0;
+	r0 = r0 < 0 ? 0 : r0;
+	c1 = c1 >= ti->cols ? ti->cols - 1 : c1;
+	r1 = r1 >= ti->rows ? ti->rows - 1 : r1;
+	ti->frame++;
+	if (c0 > c1 || r0 > r1) {
+		evict(ti);
+		return;
+	}
+	for (r = r0; r <= r1; r++) {
+		if (bandmissing(ti, r, c0, c1)) {
+			loadtiles(ti, c0, c1, r0, r1);
+			break;
+		}
+	}
+
+	vgGetMatrix(mm);
+	quality = vgGeti(VG_IMAGE_QUALITY);
+	vgSeti(VG_IMAGE_QUALITY, VG_IMAGE_QUALITY_BETTER);
+	vgSeti(VG_MATRIX_MODE, VG_MATRIX_IMAGE_USER_TO_SURFACE);
+	for (r = r0; r <= r1; r++) {
+		for (c = c0; c <= c1; c++) {
+			t = &ti->tiles[r * ti->cols + c];
+			if (t->image == VG_INVALID_HANDLE) {
+				continue;
+			}
+			vgLoadMatrix(mm);
+			vgTranslate(vx + (c * ts - ox) * zoom, vy + (r * ts - oy) * zoom);
+			vgScale(zoom, zoom);
+			vgDrawImage(t->image);
+			t->drawn = ti->frame;
+		}
+	}
+	vgSeti(VG_MATRIX_MODE, VG_MATRIX_PATH_USER_TO_SURFACE);
+	vgSeti(VG_IMAGE_QUALITY, quality);
+	evict(ti);
+	vgcheck("TiledImageDraw");
+}
+
+// TiledImageClose frees the tiles
+void TiledImageClose(TiledImage * ti) {
+	int i;
+
+	if (ti == NULL) {
+		return;
+	}
+	for (i = 0; ti->tiles != NULL && i < ti->cols * ti->rows; i++) {
+		if (ti->tiles[i].image != VG_INVALID_HANDLE) {
+			vgDestroyImage(ti->tiles[i].image);
+		}
+	}
+	free(ti->tiles);
+	free(ti->filename);
+	free(ti);
+}
@@ -0,0 +1,177 @@
+// mkcolorhash -- make a perfect hash table of color names, for openvg's Colorlookup
+//
+// Input lines are: name, hex value, r,g,b (as go-client/colortab/svgcolors.txt).
+// Each name hashes to one of a few buckets; each bucket has a seed that sends its names
+// to distinct free slots of the table, so a lookup is two hashes and one string compare.
+package main
+
+import (
+	"bufio"
+	"flag"
+	"fmt"
+	"go/format"
+	"io/ioutil"
+	"os"
+	"sort"
+	"strings"
+)
+
+const (
+	nbuckets = 64
+	nslots   = 256
+)
+
+type entry struct {
+	name    string
+	r, g, b uint8
+}
+
+// colorhash is written into the generated file; hash is the same function, for building the table
+const colorhash = `
+// colorhash is a seeded FNV-1a hash
+func colorhash(seed uint32, s string) uint32 {
+	h := 2166136261 ^ seed*0x9e3779b9
+	for i := 0; i < len(s); i++ {
+		h ^= uint32(s[i])
+		h *= 16777619
+	}
+	h ^= h >> 15
+	h *= 0x2c1b3c6d
+	return h ^ h>>12
+}
+`
+
+func hash(seed uint32, s string) uint32 {
+	h := 2166136261 ^ seed*0x9e3779b9
+	for i := 0; i < len(s); i++ {
+		h ^= uint32(s[i])
+		h *= 16777619
+	}
+	h ^= h >> 15
+	h *= 0x2c1b3c6d
+	return h ^ h>>12
+}
+
+// readcolors reads the color table
+func readcolors(filename string) ([]entry, error) {
+	f, err := os.Open(filename)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+	var colors []entry
+	seen := map[string]bool{}
+	scanner := bufio.NewScanner(f)
+	for scanner.Scan() {
+		fields := strings.Fields(scanner.Text())
+		if len(fields) != 3 {
+			continue
+		}
+		var e entry
+		e.name = fields[0]
+		if n, err := fmt.Sscanf(fields[2], "%d,%d,%d", &e.r, &e.g, &e.b); n != 3 || err != nil {
+			return nil, fmt.Errorf("%s: bad color %q", filename, scanner.Text())
+		}
+		if !seen[e.name] {
+			seen[e.name] = true
+			colors = append(colors, e)
+		}
+	}
+	return colors, scanner.Err()
+}
+
+// build finds a seed for each bucket that places all of its names in free slots,
+// filling the largest buckets first
+func build(colors []entry) ([nbuckets]uint32, [nslots]*entry, error) {
+	var seeds [nbuckets]uint32
+	var slots [nslots]*entry
+	buckets := make([][]*entry, nbuckets)
+	for i := range colors {
+		b := hash(0, colors[i].name) % nbuckets
+		buckets[b] = append(buckets[b], &colors[i])
+	}
+	order := make([]int, nbuckets)
+	for i := range order {
+		order[i] = i
+	}
+	sort.SliceStable(order, func(i, j int) bool { return len(buckets[order[i]]) > len(buckets[order[j]]) })
+	for _, b := range order {
+		if len(buckets[b]) == 0 {
+			continue
+		}
+	search:
+		for seed := uint32(1); ; seed++ {
+			if seed > 1<<20 {
+				return seeds, slots, fmt.Errorf("no seed for bucket %d", b)
+			}
+			used := map[uint32]bool{}
+			for _, e := range buckets[b] {
+				s := hash(seed, e.name) % nslots
+				if slots[s] != nil || used[s] {
+					continue search
+				}
+				used[s] = true
+			}
+			for _, e := range buckets[b] {
+				slots[hash(seed, e.name)%nslots] = e
+			}
+			seeds[b] = seed
+			break
+		}
+	}
+	return seeds, slots, nil
+}
+
+func main() {
+	var (
+		input  = flag.String("f", "go-client/colortab/svgcolors.txt", "color table")
+		output = flag.String("o", "colorhash.go", "output file")
+	)
+	flag.Parse()
+
+	colors, err := readcolors(*input)
+	if err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+	seeds, slots, err := build(colors)
+	if err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+
+	var w strings.Builder
+	fmt.Fprintf(&w, "// Code generated by mkcolorhash from %s; DO NOT EDIT.\n\npackage openvg\n", *input)
+	fmt.Fprintf(&w, "\nconst (\n\tcolorbuckets = %d\n\tcolorslots = %d\n)\n", nbuckets, nslots)
+	w.WriteString(colorhash)
+	w.WriteString("\n// colorseeds holds the second hash seed of each bucket\nvar colorseeds = [colorbuckets]uint32{")
+	for i, s := range seeds {
+		if i%16 == 0 {
+			w.WriteString("\n")
+		}
+		fmt.Fprintf(&w, "%d, ", s)
+	}
+	w.WriteString("\n}\n\n// colortable holds the SVG colors by slot\nvar colortable = [colorslots]struct {\n\tname string\n\tRGB\n}{\n")
+	for i, e := range slots {
+		if e != nil {
+			fmt.Fprintf(&w, "%d: {%q, RGB{%d, %d, %d}},\n", i, e.name, e.r, e.g, e.b)
+		}
+	}
+	w.WriteString(`}
+
+// svgcolor returns the named SVG color
+func svgcolor(s string) (RGB, bool) {
+	e := &colortable[colorhash(colorseeds[colorhash(0, s)%colorbuckets], s)%colorslots]
+	return e.RGB, e.name == s && s != ""
+}
+`)
+	src, err := format.Source([]byte(w.String()))
+	if err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+	if err := ioutil.WriteFile(*output, src, 0644); err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+}
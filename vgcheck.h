@@ -0,0 +1,7 @@
+//
+// vgcheck: error checking inside the library, not part of the API
+//
+// Drawing and upload functions call vgcheck with their name after their
+// OpenVG calls; with ERRORS_DEBUG it reports any error as theirs.
+//
+extern void vgcheck(const char *);
@@ -0,0 +1,184 @@
+//
+// yuv: conversion of video frames to RGBA rasters
+//
+// The frame's top row becomes the last row of the raster, so the
+// result is in OpenVG order and can be uploaded without a flip.
+// Rows are converted 16 pixels at a time with NEON on ARM
+// (build with -mfpu=neon) or SSE2 on x86; the scalar code handles
+// what remains and gives identical results.
+//
+#include <stdlib.h>
+#include "VG/openvg.h"
+#include "VG/vgu.h"
+#include "fontinfo.h"
+#include "shapes.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define YUV_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define YUV_SSE2
+#endif
+
+// YUVcoef holds conversion coefficients in 1/64 units:
+// R = ymul*(Y-yoff) + rv*(V-128)
+// G = ymul*(Y-yoff) - gu*(U-128) - gv*(V-128)
+// B = ymul*(Y-yoff) + bu*(U-128)
+typedef struct {
+	short yoff, ymul, rv, gu, gv, bu;
+} YUVcoef;
+
+static const YUVcoef yuvcoef[] = {
+	{16, 75, 102, 25, 52, 129},			   // YUV_VIDEO: BT.601, Y in 16..235
+	{0, 64, 90, 22, 46, 113},			   // YUV_FULL: JFIF, Y in 0..255
+};
+
+// clamp6 rounds off the 1/64 units and clamps to a byte
+static inline VGubyte clamp6(int v) {
+	v = (v + 32) >> 6;
+	return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+// yuvpixels converts pixels [x, w) of a row; u and v advance every uvstep bytes per two pixels
+static void yuvpixels(VGubyte * dst, const VGubyte * y, const VGubyte * u, const VGubyte * v, int uvstep, int x, int w,
+		      const YUVcoef * c) {
+	int yv, d, e;
+	for (; x < w; x++) {
+		yv = (y[x] - c->yoff) * c->ymul;
+		d = u[(x >> 1) * uvstep] - 128;
+		e = v[(x >> 1) * uvstep] - 128;
+		dst[x * 4 + 0] = clamp6(yv + c->rv * e);
+		dst[x * 4 + 1] = clamp6(yv - c->gu * d - c->gv * e);
+		dst[x * 4 + 2] = clamp6(yv + c->bu * d);
+		dst[x * 4 + 3] = 255;
+	}
+}
+
+#if defined(YUV_NEON)
+// yuvneon converts 16 pixels from luma and 8 chroma pairs
+static inline void yuvneon(VGubyte * dst, uint8x16_t yy, uint8x8_t u, uint8x8_t v, const YUVcoef * c) {
+	int16x8_t d = vreinterpretq_s16_u16(vsubl_u8(u, vdup_n_u8(128)));
+	int16x8_t e = vreinterpretq_s16_u16(vsubl_u8(v, vdup_n_u8(128)));
+	int16x8x2_t dd = vzipq_s16(d, d);
+	int16x8x2_t ee = vzipq_s16(e, e);
+	int16x8_t ylo = vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(yy), vdup_n_u8(c->yoff)));
+	int16x8_t yhi = vreinterpretq_s16_u16(vsubl_u8(vget_high_u8(yy), vdup_n_u8(c->yoff)));
+	int16x8_t y0 = vmulq_n_s16(ylo, c->ymul);
+	int16x8_t y1 = vmulq_n_s16(yhi, c->ymul);
+	uint8x16x4_t px;
+
+	px.val[0] = vcombine_u8(vqrshrun_n_s16(vqaddq_s16(y0, vmulq_n_s16(ee.val[0], c->rv)), 6),
+				vqrshrun_n_s16(vqaddq_s16(y1, vmulq_n_s16(ee.val[1], c->rv)), 6));
+	px.val[1] = vcombine_u8(vqrshrun_n_s16(vqsubq_s16(vqsubq_s16(y0, vmulq_n_s16(dd.val[0], c->gu)),
+							  vmulq_n_s16(ee.val[0], c->gv)), 6),
+				vqrshrun_n_s16(vqsubq_s16(vqsubq_s16(y1, vmulq_n_s16(dd.val[1], c->gu)),
+							  vmulq_n_s16(ee.val[1], c->gv)), 6));
+	px.val[2] = vcombine_u8(vqrshrun_n_s16(vqaddq_s16(y0, vmulq_n_s16(dd.val[0], c->bu)), 6),
+				vqrshrun_n_s16(vqaddq_s16(y1, vmulq_n_s16(dd.val[1], c->bu)), 6));
+	px.val[3] = vdupq_n_u8(255);
+	vst4q_u8(dst, px);
+}
+#endif
+
+#if defined(YUV_SSE2)
+// yuvhalf computes red, green and blue for 8 pixels as 16-bit values
+static inline void yuvhalf(__m128i y, __m128i d, __m128i e, const YUVcoef * c, __m128i * r, __m128i * g, __m128i * b) {
+	const __m128i round = _mm_set1_epi16(32);
+	__m128i yv = _mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(c->yoff)), _mm_set1_epi16(c->ymul));
+
+	*r = _mm_adds_epi16(yv, _mm_mullo_epi16(e, _mm_set1_epi16(c->rv)));
+	*g = _mm_subs_epi16(_mm_subs_epi16(yv, _mm_mullo_epi16(d, _mm_set1_epi16(c->gu))),
+			    _mm_mullo_epi16(e, _mm_set1_epi16(c->gv)));
+	*b = _mm_adds_epi16(yv, _mm_mullo_epi16(d, _mm_set1_epi16(c->bu)));
+	*r = _mm_srai_epi16(_mm_adds_epi16(*r, round), 6);
+	*g = _mm_srai_epi16(_mm_adds_epi16(*g, round), 6);
+	*b = _mm_srai_epi16(_mm_adds_epi16(*b, round), 6);
+}
+
+// yuvsse2 converts 16 pixels from luma and 8 chroma pairs held as 16-bit values
+static inline void yuvsse2(VGubyte * dst, __m128i yy, __m128i u, __m128i v, const YUVcoef * c) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c128 = _mm_set1_epi16(128);
+	__m128i d = _mm_sub_epi16(u, c128);
+	__m128i e = _mm_sub_epi16(v, c128);
+	__m128i rlo, glo, blo, rhi, ghi, bhi, r, g, b, rg, ba;
+
+	yuvhalf(_mm_unpacklo_epi8(yy, zero), _mm_unpacklo_epi16(d, d), _mm_unpacklo_epi16(e, e), c, &rlo, &glo, &blo);
+	yuvhalf(_mm_unpackhi_epi8(yy, zero), _mm_unpackhi_epi16(d, d), _mm_unpackhi_epi16(e, e), c, &rhi, &ghi, &bhi);
+	r = _mm_packus_epi16(rlo, rhi);
+	g = _mm_packus_epi16(glo, ghi);
+	b = _mm_packus_epi16(blo, bhi);
+
+	rg = _mm_unpacklo_epi8(r, g);
+	ba = _mm_unpacklo_epi8(b, _mm_set1_epi8(-1));
+	_mm_storeu_si128((__m128i *) dst, _mm_unpacklo_epi16(rg, ba));
+	_mm_storeu_si128((__m128i *) (dst + 16), _mm_unpackhi_epi16(rg, ba));
+	rg = _mm_unpackhi_epi8(r, g);
+	ba = _mm_unpackhi_epi8(b, _mm_set1_epi8(-1));
+	_mm_storeu_si128((__m128i *) (dst + 32), _mm_unpacklo_epi16(rg, ba));
+	_mm_storeu_si128((__m128i *) (dst + 48), _mm_unpackhi_epi16(rg, ba));
+}
+#endif
+
+// i420row converts a row with chroma from separate u and v planes
+static void i420row(VGubyte * dst, const VGubyte * y, const VGubyte * u, const VGubyte * v, int w, const YUVcoef * c) {
+	int x = 0;
+#if defined(YUV_NEON)
+	for (; x + 16 <= w; x += 16) {
+		yuvneon(dst + x * 4, vld1q_u8(y + x), vld1_u8(u + x / 2), vld1_u8(v + x / 2), c);
+	}
+#elif defined(YUV_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	for (; x + 16 <= w; x += 16) {
+		yuvsse2(dst + x * 4, _mm_loadu_si128((const __m128i *)(y + x)),
+			_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(u + x / 2)), zero),
+			_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(v + x / 2)), zero), c);
+	}
+#endif
+	yuvpixels(dst, y, u, v, 1, x, w, c);
+}
+
+// nv12row converts a row with interleaved u, v chroma
+static void nv12row(VGubyte * dst, const VGubyte * y, const VGubyte * uv, int w, const YUVcoef * c) {
+	int x = 0;
+#if defined(YUV_NEON)
+	uint8x8x2_t p;
+	for (; x + 16 <= w; x += 16) {
+		p = vld2_u8(uv + x);
+		yuvneon(dst + x * 4, vld1q_u8(y + x), p.val[0], p.val[1], c);
+	}
+#elif defined(YUV_SSE2)
+	const __m128i lo = _mm_set1_epi16(0xff);
+	__m128i p;
+	for (; x + 16 <= w; x += 16) {
+		p = _mm_loadu_si128((const __m128i *)(uv + x));
+		yuvsse2(dst + x * 4, _mm_loadu_si128((const __m128i *)(y + x)), _mm_and_si128(p, lo), _mm_srli_epi16(p, 8), c);
+	}
+#endif
+	yuvpixels(dst, y, uv, uv + 1, 2, x, w, c);
+}
+
+// I420toRGBA converts a planar 4:2:0 frame to a w x h raster of red, green, blue, alpha values
+// in OpenVG (bottom row first) order, with dststride bytes per raster row.
+// range is YUV_VIDEO for 16..235 luma (BT.601), or YUV_FULL (JFIF).
+void I420toRGBA(VGubyte * dst, int dststride, const VGubyte * y, const VGubyte * u, const VGubyte * v,
+		int ystride, int uvstride, int w, int h, int range) {
+	const YUVcoef *c = &yuvcoef[range == YUV_FULL ? 1 : 0];
+	int row;
+	for (row = 0; row < h; row++) {
+		i420row(dst + (h - 1 - row) * dststride, y + row * ystride, u + (row >> 1) * uvstride,
+			v + (row >> 1) * uvstride, w, c);
+	}
+}
+
+// NV12toRGBA converts a semi-planar 4:2:0 frame, with interleaved u, v chroma,
+// to a w x h raster of red, green, blue, alpha values in OpenVG order.
+void NV12toRGBA(VGubyte * dst, int dststride, const VGubyte * y, const VGubyte * uv, int ystride, int uvstride, int w, int h,
+		int range) {
+	const YUVcoef *c = &yuvcoef[range == YUV_FULL ? 1 : 0];
+	int row;
+	for (row = 0; row < h; row++) {
+		nv12row(dst + (h - 1 - row) * dststride, y + row * ystride, uv + (row >> 1) * uvstride, w, c);
+	}
+}